@@ -0,0 +1,286 @@
+#include "Arena.h"
+
+#include <algorithm>
+
+namespace sim {
+
+namespace {
+
+// snakes per range are a multiple of this, neighbouring ranges do not share cache lines of the per snake arrays
+constexpr uint32_t RANGE_ALIGNMENT = 64;
+// random cells tried for a new snake or an apple before giving up for this tick
+constexpr int PLACEMENT_ATTEMPTS = 64;
+
+uint32_t workerCount(const ArenaSettings& settings) {
+	const uint32_t threads = settings.threadCount > 0 ? settings.threadCount : std::max(1u, std::thread::hardware_concurrency());
+	const uint32_t ranges = std::max(1u, (settings.snakeCount + RANGE_ALIGNMENT - 1) / RANGE_ALIGNMENT);
+	return std::min(threads, ranges) - 1;
+}
+
+}
+
+//------------- Arena
+
+Arena::Arena(const ArenaSettings& settings)
+	: settings(settings), snakes(settings.snakeCount),
+	occupants(static_cast<size_t>(settings.snakeCount) * settings.startLength * 4 + settings.appleCount), rng(settings.seed),
+	nextHeads(settings.snakeCount), isGrowing(settings.snakeCount), outcomes(settings.snakeCount, ArenaOutcome::MOVED), targets(settings.snakeCount),
+	startBarrier(workerCount(settings) + 1), endBarrier(workerCount(settings) + 1) {
+	apples.reserve(settings.appleCount);
+	for (uint32_t snake = 0; snake < settings.snakeCount; ++snake)
+		if (!spawn(snake))
+			outcomes[snake] = ArenaOutcome::NOT_PLAYING;
+	placeApples();
+
+	const uint32_t count = workerCount(settings);
+	for (uint32_t worker = 1; worker <= count; ++worker)
+		workers.emplace_back([this, worker]() { work(worker); });
+}
+
+Arena::~Arena() {
+	if (workers.empty())
+		return;
+	isStopping = true;
+	startBarrier.arrive_and_wait();
+	for (std::thread& worker : workers)
+		worker.join();
+}
+
+void Arena::moveRange(uint32_t begin, uint32_t end, const Action* actions) {
+	for (uint32_t snake = begin; snake < end; ++snake) {
+		ArenaSnake& current = snakes[snake];
+		if (!current.isAlive) {
+			outcomes[snake] = ArenaOutcome::NOT_PLAYING;
+			isGrowing[snake] = 0;
+			continue;
+		}
+		current.dir = turned(current.dir, actions[snake]);
+		const Cell next = current.cells.front().addCell(Cell::deltaCell(current.dir));
+		nextHeads[snake] = next;
+		const bool isWall = !isInside(next);
+		const uint32_t occupant = isWall ? EMPTY : occupants.find(next);
+		isGrowing[snake] = occupant != EMPTY && (occupant & APPLE_FLAG) != 0;
+		outcomes[snake] = isWall ? ArenaOutcome::HIT_WALL : ArenaOutcome::MOVED;
+	}
+}
+
+void Arena::findHeadOns() {
+	targets.clear();
+	for (uint32_t snake = 0; snake < snakes.size(); ++snake) {
+		if (outcomes[snake] == ArenaOutcome::NOT_PLAYING || outcomes[snake] == ArenaOutcome::HIT_WALL)
+			continue;
+		const uint32_t first = targets.find(nextHeads[snake]);
+		if (first == CellHash::NOT_FOUND) {
+			targets.insert(nextHeads[snake], snake);
+		} else {
+			// dead snakes do not eat the apple, their tails count as vacated
+			outcomes[first] = ArenaOutcome::HEAD_ON;
+			outcomes[snake] = ArenaOutcome::HEAD_ON;
+			isGrowing[first] = 0;
+			isGrowing[snake] = 0;
+		}
+	}
+}
+
+void Arena::collideRange(uint32_t begin, uint32_t end) {
+	for (uint32_t snake = begin; snake < end; ++snake) {
+		if (outcomes[snake] != ArenaOutcome::MOVED)
+			continue;
+		const uint32_t occupant = occupants.find(nextHeads[snake]);
+		if (occupant == EMPTY)
+			continue;
+		if (occupant & APPLE_FLAG) {
+			outcomes[snake] = ArenaOutcome::ATE_APPLE;
+			continue;
+		}
+		// the tail leaves its cell in this tick unless its snake grows
+		const bool isVacated = nextHeads[snake].isSameAs(snakes[occupant].cells.back()) && !isGrowing[occupant];
+		if (!isVacated)
+			outcomes[snake] = occupant == snake ? ArenaOutcome::BIT_ITSELF : ArenaOutcome::HIT_SNAKE;
+	}
+}
+
+void Arena::eraseCell(const Cell& cell, uint32_t occupant) {
+	if (occupants.find(cell) == occupant)
+		occupants.erase(cell);
+}
+
+void Arena::removeApple(uint32_t apple) {
+	occupants.erase(apples[apple]);
+	apples[apple] = apples.back();
+	apples.pop_back();
+	if (apple < apples.size())
+		occupants.insert(apples[apple], APPLE_FLAG | apple);
+}
+
+void Arena::apply() {
+	// Cells are freed before heads move in: the dead, then the tails that leave
+	for (uint32_t snake = 0; snake < snakes.size(); ++snake) {
+		ArenaSnake& current = snakes[snake];
+		if (isDeath(outcomes[snake])) {
+			for (const Cell& cell : current.cells)
+				eraseCell(cell, snake);
+			segmentCount -= current.cells.size();
+			current.cells.clear();
+			current.isAlive = false;
+		} else if (outcomes[snake] == ArenaOutcome::MOVED) {
+			eraseCell(current.cells.back(), snake);
+			current.cells.popBack();
+			--segmentCount;
+		}
+	}
+	for (uint32_t snake = 0; snake < snakes.size(); ++snake) {
+		const ArenaOutcome outcome = outcomes[snake];
+		if (outcome != ArenaOutcome::MOVED && outcome != ArenaOutcome::ATE_APPLE)
+			continue;
+		ArenaSnake& current = snakes[snake];
+		const Cell& next = nextHeads[snake];
+		if (outcome == ArenaOutcome::ATE_APPLE) {
+			removeApple(occupants.find(next) & ~APPLE_FLAG);
+			++current.score;
+		}
+		current.cells.pushFront(next);
+		occupants.insert(next, snake);
+		++segmentCount;
+	}
+
+	if (settings.isRespawning)
+		for (uint32_t snake = 0; snake < snakes.size(); ++snake)
+			if (!snakes[snake].isAlive)
+				spawn(snake);
+	placeApples();
+}
+
+void Arena::placeApples() {
+	const uint64_t cellCount = static_cast<uint64_t>(settings.gridSize) * settings.gridSize;
+	for (int attempt = 0; apples.size() < settings.appleCount && attempt < PLACEMENT_ATTEMPTS; ++attempt) {
+		const uint64_t ix = rng.nextBelow(static_cast<uint32_t>(cellCount));
+		const Cell cell{ static_cast<int32_t>(ix % settings.gridSize), static_cast<int32_t>(ix / settings.gridSize) };
+		if (occupants.find(cell) != EMPTY)
+			continue;
+		occupants.insert(cell, APPLE_FLAG | static_cast<uint32_t>(apples.size()));
+		apples.push_back(cell);
+		attempt = 0;
+	}
+}
+
+bool Arena::spawn(uint32_t snake) {
+	const uint64_t cellCount = static_cast<uint64_t>(settings.gridSize) * settings.gridSize;
+	const uint32_t length = std::max(1u, settings.startLength);
+	for (int attempt = 0; attempt < PLACEMENT_ATTEMPTS; ++attempt) {
+		const uint64_t ix = rng.nextBelow(static_cast<uint32_t>(cellCount));
+		const Cell head{ static_cast<int32_t>(ix % settings.gridSize), static_cast<int32_t>(ix / settings.gridSize) };
+		const Direction dir = static_cast<Direction>(rng.nextBelow(4));
+		const Cell delta = Cell::deltaCell(dir);
+		// the body trails behind the head, the cell ahead is free too
+		bool isRoom = isFree(head.addCell(delta));
+		for (uint32_t segment = 0; segment < length && isRoom; ++segment)
+			isRoom = isFree(Cell{ head.x - delta.x * static_cast<int32_t>(segment), head.y - delta.y * static_cast<int32_t>(segment) });
+		if (!isRoom)
+			continue;
+
+		ArenaSnake& current = snakes[snake];
+		current.cells.clear();
+		for (uint32_t segment = 0; segment < length; ++segment) {
+			const Cell cell{ head.x - delta.x * static_cast<int32_t>(segment), head.y - delta.y * static_cast<int32_t>(segment) };
+			current.cells.pushBack(cell);
+			occupants.insert(cell, snake);
+		}
+		current.dir = dir;
+		current.isAlive = true;
+		current.score = 0;
+		segmentCount += length;
+		return true;
+	}
+	return false;
+}
+
+void Arena::range(uint32_t worker, uint32_t& begin, uint32_t& end) const {
+	const uint32_t snakeCount = static_cast<uint32_t>(snakes.size());
+	const uint32_t rangeCount = static_cast<uint32_t>(workers.size()) + 1;
+	const uint32_t blocks = (snakeCount + RANGE_ALIGNMENT - 1) / RANGE_ALIGNMENT;
+	begin = std::min(snakeCount, blocks * worker / rangeCount * RANGE_ALIGNMENT);
+	end = std::min(snakeCount, blocks * (worker + 1) / rangeCount * RANGE_ALIGNMENT);
+}
+
+void Arena::runPass(int pass, const Action* actions) {
+	if (workers.empty()) {
+		if (pass == 0)
+			moveRange(0, static_cast<uint32_t>(snakes.size()), actions);
+		else
+			collideRange(0, static_cast<uint32_t>(snakes.size()));
+		return;
+	}
+	pendingPass = pass;
+	pendingActions = actions;
+	startBarrier.arrive_and_wait();
+	uint32_t begin, end;
+	range(0, begin, end);
+	if (pass == 0)
+		moveRange(begin, end, actions);
+	else
+		collideRange(begin, end);
+	endBarrier.arrive_and_wait();
+}
+
+void Arena::work(uint32_t worker) {
+	while (true) {
+		startBarrier.arrive_and_wait();
+		if (isStopping)
+			return;
+		uint32_t begin, end;
+		range(worker, begin, end);
+		if (pendingPass == 0)
+			moveRange(begin, end, pendingActions);
+		else
+			collideRange(begin, end);
+		endBarrier.arrive_and_wait();
+	}
+}
+
+void Arena::step(const Action* actions) {
+	// parallel: turns and next heads. Serial: heads into the same cell. Parallel: bodies. Serial: the changes
+	runPass(0, actions);
+	findHeadOns();
+	runPass(1, nullptr);
+	apply();
+	++ticks;
+}
+
+//------------- bots
+
+Action chooseBotAction(const Arena& arena, uint32_t snake, Rng& rng) {
+	const ArenaSnake& current = arena.getSnake(snake);
+	if (!current.isAlive)
+		return Action::NONE;
+
+	// straight on wins ties, a wandering bot gives the turns a random bonus
+	const bool isWandering = rng.nextBelow(16) == 0;
+	Action best = Action::NONE;
+	int bestScore = -1;
+	for (const Action action : { Action::NONE, Action::TURN_LEFT, Action::TURN_RIGHT }) {
+		const Cell cell = current.cells.front().addCell(Cell::deltaCell(turned(current.dir, action)));
+		int score = 0;
+		const uint32_t occupant = arena.getOccupant(cell);
+		const bool isInside = static_cast<uint32_t>(cell.x) < static_cast<uint32_t>(arena.getGridSize())
+			&& static_cast<uint32_t>(cell.y) < static_cast<uint32_t>(arena.getGridSize());
+		if (!isInside)
+			score = 0;
+		else if (occupant == Arena::EMPTY)
+			score = 2;
+		else if (occupant & Arena::APPLE_FLAG)
+			score = 4;
+		else
+			// a tail usually moves on
+			score = cell.isSameAs(arena.getSnake(occupant).cells.back()) ? 1 : 0;
+		if (isWandering && action != Action::NONE && score > 0)
+			score += static_cast<int>(rng.nextBelow(2)) * 2;
+		if (score > bestScore) {
+			best = action;
+			bestScore = score;
+		}
+	}
+	return best;
+}
+
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "Cell.h"
+#include "CellHash.h"
+#include "Rng.h"
+#include "Simulation.h"
+
+#include <RingBuffer.h>
+
+#include <barrier>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace sim {
+
+struct ArenaSettings {
+	int32_t gridSize = 100;
+	uint32_t snakeCount = 100;
+	// apples on the grid after every tick, as long as there is room
+	uint32_t appleCount = 100;
+	uint32_t startLength = 3;
+	// a snake that died starts again somewhere else at the end of the tick
+	bool isRespawning = true;
+	uint64_t seed = 1;
+	// 0 for one per hardware thread
+	uint32_t threadCount = 1;
+};
+
+enum class ArenaOutcome : uint8_t {
+	MOVED, ATE_APPLE, HIT_WALL, BIT_ITSELF,
+	// head into the body of another snake
+	HIT_SNAKE,
+	// two or more heads into the same cell, all of them die
+	HEAD_ON,
+	// dead before the tick and no room to start again
+	NOT_PLAYING
+};
+
+inline bool isDeath(ArenaOutcome outcome) {
+	return outcome != ArenaOutcome::MOVED && outcome != ArenaOutcome::ATE_APPLE && outcome != ArenaOutcome::NOT_PLAYING;
+}
+
+struct ArenaSnake {
+	// from head to tail
+	gds::RingBuffer<Cell> cells;
+	Direction dir = Direction::LEFT;
+	bool isAlive = false;
+	uint32_t score{};
+};
+
+// Many snakes and apples on one grid, all snakes move in the same tick. Same turns and moves as sim::step.
+//
+// Every segment and apple is in one CellHash, the shared spatial index: a collision is one lookup of the cell a head
+// moves into, whatever the number of snakes. Moves are simultaneous, resolved against the bodies before the tick:
+// - heads that move into the same cell all die (HEAD_ON), whether the cell holds an apple or not
+// - a head that moves into a body dies (HIT_SNAKE, or BIT_ITSELF for its own), except into a tail cell that is vacated
+//   in this tick, which is every tail whose snake does not eat an apple
+// - a dead snake is removed at the end of the tick, its cells are free from the next tick on
+// A tick is two parallel passes over ranges of snakes, turn and move, then collide, with the head-on check
+// between them and the changes applied at the end. Cost is linear in the number of snakes plus the cells that change.
+class Arena {
+public:
+	// occupant of a cell: a snake index, APPLE_FLAG | apple index, or EMPTY
+	static constexpr uint32_t EMPTY = CellHash::NOT_FOUND;
+	static constexpr uint32_t APPLE_FLAG = 1u << 31;
+
+private:
+	ArenaSettings settings;
+	std::vector<ArenaSnake> snakes;
+	CellHash occupants;
+	std::vector<Cell> apples;
+	Rng rng;
+	uint64_t ticks{};
+	size_t segmentCount{};
+
+	// scratch of a tick, per snake
+	std::vector<Cell> nextHeads;
+	std::vector<uint8_t> isGrowing;
+	std::vector<ArenaOutcome> outcomes;
+	// the cells heads move into in this tick, for head-on collisions
+	CellHash targets;
+
+	// workers beyond the calling thread, as in BatchSim
+	std::vector<std::thread> workers;
+	std::barrier<> startBarrier;
+	std::barrier<> endBarrier;
+	const Action* pendingActions = nullptr;
+	int pendingPass{};
+	bool isStopping = false;
+
+private:
+	inline bool isInside(const Cell& cell) const {
+		return static_cast<uint32_t>(cell.x) < static_cast<uint32_t>(settings.gridSize) && static_cast<uint32_t>(cell.y) < static_cast<uint32_t>(settings.gridSize);
+	}
+	void moveRange(uint32_t begin, uint32_t end, const Action* actions);
+	void collideRange(uint32_t begin, uint32_t end);
+	void findHeadOns();
+	void apply();
+	void range(uint32_t worker, uint32_t& begin, uint32_t& end) const;
+	void runPass(int pass, const Action* actions);
+	void work(uint32_t worker);
+	void eraseCell(const Cell& cell, uint32_t occupant);
+	void removeApple(uint32_t apple);
+	void placeApples();
+	bool spawn(uint32_t snake);
+
+public:
+	Arena(const ArenaSettings& settings);
+	Arena(const Arena& other) = delete;
+	Arena& operator=(const Arena& other) = delete;
+	~Arena();
+
+	// one tick of every snake, actions[snake]. Actions of snakes that are not alive are ignored.
+	void step(const Action* actions);
+
+	int32_t getGridSize() const { return settings.gridSize; }
+	uint32_t getSnakeCount() const { return static_cast<uint32_t>(snakes.size()); }
+	uint32_t getThreadCount() const { return static_cast<uint32_t>(workers.size()) + 1; }
+	const ArenaSnake& getSnake(uint32_t snake) const { return snakes[snake]; }
+	const std::vector<Cell>& getApples() const { return apples; }
+	// outcome of each snake in the last step
+	const ArenaOutcome* getOutcomes() const { return outcomes.data(); }
+	uint32_t getOccupant(const Cell& cell) const { return occupants.find(cell); }
+	bool isFree(const Cell& cell) const { return isInside(cell) && occupants.find(cell) == EMPTY; }
+	// segments of all living snakes
+	size_t getSegmentCount() const { return segmentCount; }
+	uint64_t getTicks() const { return ticks; }
+};
+
+// A simple bot: straight on while that is free, turns toward an apple next to it or away from what is ahead,
+// and now and then at random.
+Action chooseBotAction(const Arena& arena, uint32_t snake, Rng& rng);
+
+}
@@ -0,0 +1,395 @@
+#include "Autopilot.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace sim {
+
+namespace {
+
+// clearing the field for a build goes this many cells per visited cell of the budget
+constexpr uint64_t CLEARS_PER_VISIT = 16;
+// an empty level of the bucket queue, the end of a level's list
+constexpr uint32_t NO_CELL = UINT32_MAX;
+
+}
+
+//------------- Autopilot
+
+Autopilot::Autopilot(uint32_t buildCellsPerTick)
+	: buildCellsPerTick(std::max(1u, buildCellsPerTick)) {
+}
+
+void Autopilot::reserve(int32_t size) {
+	const uint64_t cellCount = static_cast<uint64_t>(size) * size;
+	if (fieldGridSize == size)
+		return;
+	isSynced = false;
+	isBuilding = false;
+	isReady = false;
+	if (cellCount > MAX_FIELD_CELLS) {
+		fieldGridSize = 0;
+		std::vector<uint32_t>().swap(distances);
+		std::vector<uint32_t>().swap(stamps);
+		std::vector<uint8_t>().swap(flipped);
+		std::vector<uint32_t>().swap(pending);
+		std::vector<uint32_t>().swap(queue);
+		std::vector<uint32_t>().swap(affected);
+		std::vector<uint32_t>().swap(levelHeads);
+		std::vector<uint32_t>().swap(levelNext);
+		return;
+	}
+	fieldGridSize = size;
+	distances.assign(cellCount, UNREACHABLE);
+	stamps.assign(cellCount, 0);
+	stamp = 0;
+	flipped.assign(cellCount, 0);
+	queue.assign(cellCount, 0);
+	affected.clear();
+	affected.reserve(cellCount);
+	levelHeads.assign(static_cast<size_t>(buildCellsPerTick) + 1, NO_CELL);
+	levelNext.assign(cellCount, NO_CELL);
+	// two changes per tick while a build runs
+	const uint64_t buildTicks = (cellCount + cellCount / CLEARS_PER_VISIT) / buildCellsPerTick + 2;
+	pending.clear();
+	pending.reserve(2 * buildTicks);
+}
+
+bool Autopilot::checkOrdered(const Snake& snake) const {
+	// going from the head back to the tail the cycle positions go down, all below the head
+	const gds::RingBuffer<Cell>& cells = snake.getCells();
+	const uint64_t head = cycle.getPosition(cells.front());
+	uint64_t previous = cycle.getSize();
+	for (size_t ix = 1; ix < cells.size(); ++ix) {
+		const uint64_t distance = cycle.getDistance(head, cycle.getPosition(cells[ix]));
+		if (distance == 0 || distance >= previous)
+			return false;
+		previous = distance;
+	}
+	return true;
+}
+
+void Autopilot::observe(const State& state) {
+	const Snake& snake = state.snake;
+	const gds::RingBuffer<Cell>& cells = snake.getCells();
+	const Cell& head = cells.front();
+	const bool isNextTick = isSynced && state.ticks == lastTicks + 1 && cells.size() >= 2 && cells[1].isSameAs(lastHead)
+		&& (cells.size() == lastLength || cells.size() == lastLength + 1);
+
+	if (!isNextTick) {
+		isOrdered = checkOrdered(snake);
+		successorRun = 0;
+		if (hasField())
+			startBuild(state);
+	} else {
+		successorRun = cycle.getDistance(cycle.getPosition(lastHead), cycle.getPosition(head)) == 1 ? successorRun + 1 : 0;
+		isOrdered = isOrdered || successorRun + 1 >= cells.size();
+		if (hasField()) {
+			// the head's cell first, the tail's cell is free after both. An update too large for the tick starts a build.
+			const bool isNewApple = state.hasApple != lastHasApple || !state.apple.isSameAs(lastApple);
+			const bool isGrown = cells.size() > lastLength;
+			if (isNewApple || !changeCell(snake.getGrid(), head) || (!isGrown && !head.isSameAs(lastTail) && !changeCell(snake.getGrid(), lastTail)))
+				startBuild(state);
+		}
+	}
+
+	isSynced = true;
+	lastTicks = state.ticks;
+	lastHead = head;
+	lastTail = cells.back();
+	lastLength = cells.size();
+	lastApple = state.apple;
+	lastHasApple = state.hasApple;
+}
+
+void Autopilot::startBuild(const State& state) {
+	for (uint32_t index : pending)
+		flipped[index] = 0;
+	pending.clear();
+	isReady = false;
+	isBuilding = state.hasApple;
+	clearedCount = 0;
+	queueBegin = 0;
+	queueEnd = 0;
+}
+
+void Autopilot::continueBuild(const State& state) {
+	if (!isBuilding)
+		return;
+	const OccupancyGrid& grid = state.snake.getGrid();
+	uint64_t budget = buildCellsPerTick;
+	if (clearedCount < distances.size()) {
+		const uint64_t count = std::min<uint64_t>(distances.size() - clearedCount, budget * CLEARS_PER_VISIT);
+		std::fill_n(distances.begin() + clearedCount, count, UNREACHABLE);
+		clearedCount += count;
+		if (clearedCount < distances.size())
+			return;
+		budget -= count / CLEARS_PER_VISIT;
+		const uint32_t apple = toIndex(state.apple);
+		distances[apple] = 0;
+		queue[queueEnd++] = apple;
+	}
+
+	// a cell is open if it was free when the build began
+	for (; budget > 0 && queueBegin < queueEnd; --budget) {
+		const uint32_t current = queue[queueBegin++];
+		const uint32_t distance = distances[current] + 1;
+		forEachNeighbour(current, [&](uint32_t next, const Cell& cell) {
+			if (distances[next] == UNREACHABLE && grid.isEmpty(cell) != (flipped[next] != 0)) {
+				distances[next] = distance;
+				queue[queueEnd++] = next;
+			}
+		});
+	}
+	if (queueBegin < queueEnd)
+		return;
+
+	// catch up with the body: cells it entered since, then cells it left. Cells that changed twice are as they were.
+	isBuilding = false;
+	isReady = true;
+	bool isCaughtUp = true;
+	for (uint32_t index : pending) {
+		if (isCaughtUp && flipped[index] != 0 && grid.isSnake(toCell(index))) {
+			flipped[index] = 0;
+			isCaughtUp = block(grid, index);
+		}
+	}
+	for (uint32_t index : pending) {
+		if (isCaughtUp && flipped[index] != 0) {
+			flipped[index] = 0;
+			isCaughtUp = unblock(grid, index);
+		}
+	}
+	// too much to catch up with in this tick, the field is half updated
+	if (!isCaughtUp) {
+		startBuild(state);
+		return;
+	}
+	pending.clear();
+}
+
+bool Autopilot::changeCell(const OccupancyGrid& grid, const Cell& cell) {
+	const uint32_t index = toIndex(cell);
+	if (isBuilding) {
+		flipped[index] ^= 1;
+		pending.push_back(index);
+		return true;
+	}
+	if (!isReady)
+		return true;
+	return grid.isSnake(cell) ? block(grid, index) : unblock(grid, index);
+}
+
+void Autopilot::spread(const OccupancyGrid& grid, uint32_t index) {
+	const uint32_t distance = distances[index] + 1;
+	forEachNeighbour(index, [&](uint32_t next, const Cell& cell) {
+		if (distances[next] > distance && grid.isEmpty(cell)) {
+			distances[next] = distance;
+			assert(queueEnd < queue.size());
+			queue[queueEnd++] = next;
+		}
+	});
+}
+
+bool Autopilot::block(const OccupancyGrid& grid, uint32_t index) {
+	if (distances[index] == UNREACHABLE)
+		return true;
+	if (++stamp == 0) {
+		std::fill(stamps.begin(), stamps.end(), 0);
+		stamp = 1;
+	}
+
+	// The cells whose every shortest way ran through the cell, level by level: a cell one step further than an
+	// affected one is affected too unless another neighbour one step closer to the apple is not
+	affected.clear();
+	affected.push_back(index);
+	stamps[index] = stamp;
+	for (size_t ix = 0; ix < affected.size(); ++ix) {
+		if (affected.size() > updateCellsLeft)
+			return false;
+		const uint32_t level = distances[affected[ix]];
+		forEachNeighbour(affected[ix], [&](uint32_t next, const Cell&) {
+			if (stamps[next] == stamp || distances[next] != level + 1)
+				return;
+			bool isSupported = false;
+			forEachNeighbour(next, [&](uint32_t other, const Cell&) {
+				isSupported = isSupported || (stamps[other] != stamp && distances[other] == level);
+			});
+			if (!isSupported) {
+				stamps[next] = stamp;
+				affected.push_back(next);
+			}
+		});
+	}
+	if (affected.size() > updateCellsLeft)
+		return false;
+	updateCellsLeft -= affected.size();
+
+	// their new distances: from the unaffected neighbours, then spread among them closest first
+	for (uint32_t cell : affected)
+		distances[cell] = UNREACHABLE;
+	uint32_t lowest = UNREACHABLE;
+	uint32_t highest = 0;
+	for (uint32_t cell : affected) {
+		if (!grid.isEmpty(toCell(cell)))
+			continue;
+		uint32_t best = UNREACHABLE;
+		forEachNeighbour(cell, [&](uint32_t other, const Cell&) {
+			if (stamps[other] != stamp && distances[other] != UNREACHABLE)
+				best = std::min(best, distances[other] + 1);
+		});
+		distances[cell] = best;
+		if (best != UNREACHABLE) {
+			lowest = std::min(lowest, best);
+			highest = std::max(highest, best);
+		}
+	}
+	if (lowest == UNREACHABLE)
+		return true;
+	// more levels than the bucket queue has, a region that large is cheaper to build again
+	const uint32_t levelCount = highest - lowest + 1;
+	if (levelCount > levelHeads.size())
+		return false;
+
+	// the affected cells in a bucket queue by distance, a list per level
+	for (uint32_t cell : affected) {
+		if (distances[cell] == UNREACHABLE)
+			continue;
+		uint32_t& head = levelHeads[distances[cell] - lowest];
+		levelNext[cell] = head;
+		head = cell;
+	}
+	// merged with the FIFO of the cells they reach, both in order of distance
+	queueBegin = 0;
+	queueEnd = 0;
+	uint32_t level = 0;
+	while (true) {
+		while (level < levelCount && levelHeads[level] == NO_CELL)
+			++level;
+		const bool hasSeed = level < levelCount;
+		if (!hasSeed && queueBegin == queueEnd)
+			break;
+		if (updateCellsLeft == 0) {
+			std::fill(levelHeads.begin() + level, levelHeads.begin() + levelCount, NO_CELL);
+			return false;
+		}
+		--updateCellsLeft;
+		if (queueBegin < queueEnd && (!hasSeed || distances[queue[queueBegin]] <= lowest + level)) {
+			spread(grid, queue[queueBegin++]);
+		} else {
+			const uint32_t cell = levelHeads[level];
+			levelHeads[level] = levelNext[cell];
+			spread(grid, cell);
+		}
+	}
+	return true;
+}
+
+bool Autopilot::unblock(const OccupancyGrid& grid, uint32_t index) {
+	if (!grid.isEmpty(toCell(index)))
+		return true;
+	uint32_t best = distances[index];
+	forEachNeighbour(index, [&](uint32_t other, const Cell&) {
+		if (distances[other] != UNREACHABLE)
+			best = std::min(best, distances[other] + 1);
+	});
+	if (best >= distances[index])
+		return true;
+	distances[index] = best;
+	queueBegin = 0;
+	queueEnd = 0;
+	queue[queueEnd++] = index;
+	while (queueBegin < queueEnd) {
+		if (updateCellsLeft == 0)
+			return false;
+		--updateCellsLeft;
+		spread(grid, queue[queueBegin++]);
+	}
+	return true;
+}
+
+Action Autopilot::decide(const State& state) const {
+	const Snake& snake = state.snake;
+	const OccupancyGrid& grid = snake.getGrid();
+	const Cell& head = snake.getHead();
+	const Cell& tail = snake.getTail();
+	const uint64_t headPosition = cycle.getPosition(head);
+	const uint64_t tailDistance = cycle.getDistance(headPosition, cycle.getPosition(tail));
+	uint64_t appleDistance = state.hasApple ? cycle.getDistance(headPosition, cycle.getPosition(state.apple)) : cycle.getSize();
+	// On odd grids an apple whose twin is the head or in the body is out of reach in this lap. Then the snake goes
+	// step by step round the cycle, laps of another length than the last move the body off the twin.
+	const bool isOutOfReach = state.hasApple && (appleDistance == 0 || appleDistance >= tailDistance);
+	if (isOutOfReach)
+		appleDistance = cycle.getSize();
+
+	struct Move {
+		Action action = Action::NONE;
+		Cell cell{};
+		bool isLegal = false;
+	};
+	Move moves[3] = { { Action::NONE }, { Action::TURN_LEFT }, { Action::TURN_RIGHT } };
+	// the first move of a shortest path, there may be more than one
+	uint32_t shortest = UNREACHABLE;
+	for (Move& move : moves) {
+		move.cell = head.addCell(Cell::deltaCell(turned(snake.getDirection(), move.action)));
+		move.isLegal = !grid.isWall(move.cell) && !snake.willBiteItself(move.cell);
+		if (move.isLegal)
+			shortest = std::min(shortest, getDistance(move.cell));
+	}
+
+	Action best = Action::NONE;
+	bool isFound = false;
+	bool isBestApple = false;
+	bool isBestShortest = false;
+	uint64_t bestStep = 0;
+	for (const Move& move : moves) {
+		if (!move.isLegal)
+			continue;
+		const uint64_t step = cycle.getDistance(headPosition, cycle.getPosition(move.cell));
+		const bool isApple = state.hasApple && move.cell.isSameAs(state.apple);
+		if (isOrdered) {
+			// Between head and tail on the cycle, or the tail that moves on. The last free cell may share its
+			// position with the tail on odd grids, eating it fills the grid.
+			const bool isSafe = (step > 0 && step < tailDistance) || move.cell.isSameAs(tail) || (isApple && grid.getFreeCount() == 1);
+			// no cutting past the apple, that would take another lap
+			if (!isSafe || step > appleDistance || (step == appleDistance && !isApple))
+				continue;
+		}
+		const bool isShortest = shortest != UNREACHABLE && getDistance(move.cell) == shortest;
+		// A shortest path where the cycle order allows it, else as far along the cycle as it allows: where the apple
+		// lies behind the head on the cycle, the way there is round the cycle rather than towards the apple
+		bool isBetter = isShortest != isBestShortest ? isShortest : step > bestStep;
+		if (isOrdered && isOutOfReach)
+			isBetter = step < bestStep;
+		// not on the cycle in order yet: along the cycle where it can, after a body length of that it is in order
+		if (!isOrdered && (step == 1) != (bestStep == 1))
+			isBetter = step == 1;
+		// an apple it may take it takes
+		if (isApple || isBestApple)
+			isBetter = isApple;
+		if (!isFound || isBetter) {
+			best = move.action;
+			isFound = true;
+			isBestApple = isApple;
+			isBestShortest = isShortest;
+			bestStep = step;
+		}
+	}
+	return best;
+}
+
+Action Autopilot::choose(const State& state) {
+	const int32_t size = state.snake.getGrid().getGridSize();
+	if (size != gridSize) {
+		gridSize = size;
+		cycle = HamiltonianCycle{ size };
+		isSynced = false;
+	}
+	updateCellsLeft = buildCellsPerTick;
+	observe(state);
+	if (hasField())
+		continueBuild(state);
+	return decide(state);
+}
+
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "Cell.h"
+#include "HamiltonianCycle.h"
+#include "OccupancyGrid.h"
+#include "Simulation.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace sim {
+
+// Steers the snake of a sim::State, one action per tick: the shortest path to the apple, as long as that keeps the
+// tail reachable, else along the Hamiltonian cycle.
+//
+// Shortest paths come from a BFS distance field rooted at the apple, with the body as obstacles. It is rebuilt when the
+// apple moves, a few cells per tick so that no tick takes long, and kept up to date as the body moves: the cell the
+// head enters is removed and only the cells whose distance ran through it are searched again, the cell the tail
+// leaves is added and its shorter distances spread from it. An update that would search more cells than a tick's build
+// budget gives up and the field is built again.
+// Safety is the cycle order: while the body lies on the cycle in order from tail to head, the snake may cut ahead to
+// any cell between its head and its tail on the cycle. The cells from there round to the tail are free, so the tail
+// stays reachable, and the snake never cuts past the apple, so it gets there within a lap.
+// Grids above MAX_FIELD_CELLS are steered by the cycle order alone.
+class Autopilot {
+public:
+	static constexpr uint64_t MAX_FIELD_CELLS = 1 << 20;
+	static constexpr uint32_t UNREACHABLE = UINT32_MAX;
+
+private:
+	uint32_t buildCellsPerTick;
+	HamiltonianCycle cycle;
+	int32_t gridSize{};
+
+	// distances from the apple by cell index, for grids of fieldGridSize
+	int32_t fieldGridSize{};
+	std::vector<uint32_t> distances;
+	// cells marked in the current search when equal to stamp
+	std::vector<uint32_t> stamps;
+	uint32_t stamp{};
+	// while building, cells that changed since the build began. The build sees the body as it was then.
+	std::vector<uint8_t> flipped;
+	std::vector<uint32_t> pending;
+	std::vector<uint32_t> queue;
+	size_t queueBegin{};
+	size_t queueEnd{};
+	std::vector<uint32_t> affected;
+	// a bucket queue by distance for the affected cells: the first cell of each level, the next cell of a level by cell
+	std::vector<uint32_t> levelHeads;
+	std::vector<uint32_t> levelNext;
+	// cells an update may still search in this tick
+	uint64_t updateCellsLeft{};
+	bool isBuilding = false;
+	bool isReady = false;
+	uint64_t clearedCount{};
+
+	// the state of the last choose
+	bool isSynced = false;
+	uint64_t lastTicks{};
+	Cell lastHead{};
+	Cell lastTail{};
+	size_t lastLength{};
+	Cell lastApple{};
+	bool lastHasApple = false;
+	// body on the cycle from tail to head in order. Until then the snake follows the cycle and hopes for the best.
+	bool isOrdered = false;
+	// moves in a row to the next position on the cycle, a body this long lies on the cycle in order
+	uint64_t successorRun{};
+
+private:
+	inline uint32_t toIndex(const Cell& cell) const { return static_cast<uint32_t>(cell.y) * static_cast<uint32_t>(gridSize) + static_cast<uint32_t>(cell.x); }
+	inline Cell toCell(uint32_t index) const { return Cell{ static_cast<int32_t>(index % gridSize), static_cast<int32_t>(index / gridSize) }; }
+	// visit(index, cell) of the neighbours inside the grid
+	template<typename Visit>
+	inline void forEachNeighbour(uint32_t index, Visit&& visit) const {
+		const Cell cell = toCell(index);
+		const uint32_t size = static_cast<uint32_t>(gridSize);
+		if (cell.x > 0)
+			visit(index - 1, Cell{ cell.x - 1, cell.y });
+		if (cell.x + 1 < gridSize)
+			visit(index + 1, Cell{ cell.x + 1, cell.y });
+		if (cell.y > 0)
+			visit(index - size, Cell{ cell.x, cell.y - 1 });
+		if (cell.y + 1 < gridSize)
+			visit(index + size, Cell{ cell.x, cell.y + 1 });
+	}
+
+	bool hasField() const { return fieldGridSize == gridSize && gridSize > 0; }
+	bool checkOrdered(const Snake& snake) const;
+	void observe(const State& state);
+	void startBuild(const State& state);
+	void continueBuild(const State& state);
+	// The body entered or left the cell. False when the update ran out of the tick's cells, the field is left half
+	// updated and has to be built again.
+	bool changeCell(const OccupancyGrid& grid, const Cell& cell);
+	bool block(const OccupancyGrid& grid, uint32_t index);
+	bool unblock(const OccupancyGrid& grid, uint32_t index);
+	// lowers the distances of open cells from the queue on
+	void spread(const OccupancyGrid& grid, uint32_t index);
+	Action decide(const State& state) const;
+
+public:
+	// Cells of a field build per tick, a build that does not finish goes on in the next tick. Also the cells an update
+	// of the field may search per tick, an update that needs more gives up and starts a build.
+	Autopilot(uint32_t buildCellsPerTick = 1 << 13);
+
+	// sizes the distance field for a grid, choose does not allocate on it afterwards
+	void reserve(int32_t gridSize);
+
+	// the action for the next step of the game. Follows the game from tick to tick, a state that is not the next tick
+	// of the last one (a new game, a rewind, a load) starts over.
+	Action choose(const State& state);
+
+	bool isFieldReady() const { return isReady && hasField(); }
+	// steps from the apple to the cell around the body, UNREACHABLE if there is no way or no field
+	uint32_t getDistance(const Cell& cell) const { return isFieldReady() ? distances[toIndex(cell)] : UNREACHABLE; }
+};
+
+}
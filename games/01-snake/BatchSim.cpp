@@ -0,0 +1,220 @@
+#include "BatchSim.h"
+#include "Grid.h"
+
+#include <algorithm>
+
+namespace sim {
+
+namespace {
+
+// games per range are a multiple of this, neighbouring ranges do not share cache lines of the per game arrays
+constexpr uint32_t RANGE_ALIGNMENT = 64;
+// the per game clock is rewound before it could wrap
+constexpr uint32_t MAX_TICK = 1u << 31;
+
+uint32_t workerCount(const BatchSettings& settings) {
+	const uint32_t threads = settings.threadCount > 0 ? settings.threadCount : std::max(1u, std::thread::hardware_concurrency());
+	const uint32_t ranges = std::max(1u, (settings.gameCount + RANGE_ALIGNMENT - 1) / RANGE_ALIGNMENT);
+	return std::min(threads, ranges) - 1;
+}
+
+// the branch free steps of advanceHeads are the direction tables of Cell
+constexpr int32_t deltaX(uint8_t d) { return (d == 1) - (d == 3); }
+constexpr int32_t deltaY(uint8_t d) { return (d == 0) - (d == 2); }
+static_assert([] {
+	for (uint8_t d = 0; d < 4; ++d)
+		if (deltaX(d) != DIRECTION_DX[d] || deltaY(d) != DIRECTION_DY[d])
+			return false;
+	return true;
+}());
+
+// Turn, advance and wall check of the games [begin, end). Contiguous loads and stores only and branch free,
+// so that it vectorizes. The arrays never overlap, __restrict (GCC, Clang and MSVC) spares the vectorizer its alias checks.
+// Instantiated per grid type, a Grid<W, H> turns bounds and index math into constants.
+template<typename GridType>
+void advanceHeads(uint32_t begin, uint32_t end, int32_t size, uint32_t indices, const Action* __restrict actions, uint8_t* __restrict dir,
+	const int32_t* __restrict hx, const int32_t* __restrict hy, int32_t* __restrict nx, int32_t* __restrict ny, uint32_t* __restrict tick, uint32_t* __restrict next) {
+	const GridType grid{ size, size };
+	for (uint32_t game = begin; game < end; ++game) {
+		const uint8_t d = static_cast<uint8_t>(turned(static_cast<Direction>(dir[game]), actions[game]));
+		dir[game] = d;
+		const Cell cell{ hx[game] + deltaX(d), hy[game] + deltaY(d) };
+		nx[game] = cell.x;
+		ny[game] = cell.y;
+		tick[game] += 1;
+		next[game] = grid.isInside(cell) ? game * indices + grid.toIndex(cell) : UINT32_MAX;
+	}
+}
+
+}
+
+//------------- BatchSim
+
+BatchSim::BatchSim(const BatchSettings& settings)
+	: gameCount(settings.gameCount), gridSize(settings.gridSize), cellCount(static_cast<uint32_t>(settings.gridSize * settings.gridSize)),
+	headX(gameCount), headY(gameCount), dirs(gameCount), lengths(gameCount), scores(gameCount), appleX(gameCount), appleY(gameCount),
+	ticks(gameCount), outcomes(gameCount, Outcome::MOVED),
+	nextX(gameCount), nextY(gameCount), nextCell(gameCount),
+	startBarrier(workerCount(settings) + 1), endBarrier(workerCount(settings) + 1) {
+	// once per batch, the kernel and the layout of its grid type
+	const auto choose = [this](auto grid) {
+		rowPitch = grid.getRowPitch();
+		indexCount = grid.getIndexCount();
+		advance = &advanceHeads<decltype(grid)>;
+	};
+	if (settings.isSpecialized)
+		visitGrid(gridSize, gridSize, choose);
+	else
+		choose(DynamicGrid{ gridSize, gridSize });
+	entered.assign(static_cast<size_t>(gameCount) * indexCount, 0);
+
+	rngs.reserve(gameCount);
+	for (uint32_t game = 0; game < gameCount; ++game) {
+		rngs.emplace_back(settings.seed, game);
+		reset(game);
+	}
+
+	const uint32_t count = workerCount(settings);
+	for (uint32_t worker = 1; worker <= count; ++worker)
+		workers.emplace_back([this, worker]() { work(worker); });
+}
+
+BatchSim::~BatchSim() {
+	if (workers.empty())
+		return;
+	isStopping = true;
+	startBarrier.arrive_and_wait();
+	for (std::thread& worker : workers)
+		worker.join();
+}
+
+bool BatchSim::isFree(uint32_t game, uint32_t index) const {
+	return ticks[game] - entered[game * indexCount + index] >= lengths[game];
+}
+
+bool BatchSim::isSnake(uint32_t game, const Cell& cell) const {
+	return !isFree(game, static_cast<uint32_t>(cell.y) * rowPitch + static_cast<uint32_t>(cell.x));
+}
+
+bool BatchSim::placeApple(uint32_t game) {
+	const uint32_t freeCount = cellCount - lengths[game];
+	if (freeCount == 0)
+		return false;
+
+	Rng& rng = rngs[game];
+	// cells are numbered row by row without the padding of the layout, every layout draws the same apples
+	const uint32_t width = static_cast<uint32_t>(gridSize);
+	const auto indexOf = [this, width](uint32_t cell) { return cell / width * rowPitch + cell % width; };
+	uint32_t cell = 0;
+	// a few random probes find a free cell quickly unless the grid is crowded
+	bool isFound = false;
+	for (int attempt = 0; attempt < 8 && !isFound; ++attempt) {
+		cell = rng.nextBelow(cellCount);
+		isFound = isFree(game, indexOf(cell));
+	}
+	// crowded: the k-th free cell
+	if (!isFound) {
+		uint32_t k = rng.nextBelow(freeCount);
+		for (cell = 0; cell < cellCount; ++cell)
+			if (isFree(game, indexOf(cell)) && k-- == 0)
+				break;
+	}
+	appleX[game] = static_cast<int32_t>(cell) % gridSize;
+	appleY[game] = static_cast<int32_t>(cell) / gridSize;
+	return true;
+}
+
+void BatchSim::reset(uint32_t game) {
+	// every cell of the previous game is older than any length from here on
+	ticks[game] += cellCount + 2;
+	if (ticks[game] >= MAX_TICK) {
+		std::fill_n(entered.begin() + static_cast<size_t>(game) * indexCount, indexCount, 0u);
+		ticks[game] = cellCount + 2;
+	}
+
+	// same start as sim::State: head in the middle heading left, the second cell just left of it
+	const int32_t center = gridSize / 2;
+	headX[game] = center;
+	headY[game] = center;
+	dirs[game] = static_cast<uint8_t>(Direction::LEFT);
+	lengths[game] = 2;
+	scores[game] = 0;
+	entered[toIndex(game, center, center)] = ticks[game];
+	entered[toIndex(game, center - 1, center)] = ticks[game] - 1;
+	placeApple(game);
+}
+
+void BatchSim::stepRange(uint32_t begin, uint32_t end, const Action* actions) {
+	int32_t* const hx = headX.data();
+	int32_t* const hy = headY.data();
+	const int32_t* const nx = nextX.data();
+	const int32_t* const ny = nextY.data();
+	const uint32_t* const next = nextCell.data();
+	uint32_t* const body = entered.data();
+
+	advance(begin, end, gridSize, indexCount, actions, dirs.data(), hx, hy, nextX.data(), nextY.data(), ticks.data(), nextCell.data());
+
+	// Self collision, apple and commit. Reads and writes the body cell of each game, a gather and a scatter.
+	for (uint32_t game = begin; game < end; ++game) {
+		const uint32_t cell = next[game];
+		const bool isWall = cell == UINT32_MAX;
+		const uint32_t t = ticks[game];
+		// the tail cell turns free with this tick, so moving into it is not a bite
+		const bool isBite = !isWall && t - body[cell] < lengths[game];
+		const bool isEat = !isWall && !isBite && nx[game] == appleX[game] && ny[game] == appleY[game];
+		outcomes[game] = isWall ? Outcome::HIT_WALL : isBite ? Outcome::BIT_ITSELF : isEat ? Outcome::ATE_APPLE : Outcome::MOVED;
+		if (isWall || isBite)
+			continue;
+		hx[game] = nx[game];
+		hy[game] = ny[game];
+		body[cell] = t;
+		lengths[game] += isEat;
+		scores[game] += isEat;
+	}
+
+	// Rare and branchy, per game: new apples, finished games
+	for (uint32_t game = begin; game < end; ++game) {
+		const Outcome result = outcomes[game];
+		if (result == Outcome::ATE_APPLE) {
+			if (!placeApple(game))
+				reset(game); // grid full
+		}
+		else if (isGameOver(result))
+			reset(game);
+	}
+}
+
+void BatchSim::range(uint32_t worker, uint32_t& begin, uint32_t& end) const {
+	const uint32_t rangeCount = static_cast<uint32_t>(workers.size()) + 1;
+	const uint32_t blocks = (gameCount + RANGE_ALIGNMENT - 1) / RANGE_ALIGNMENT;
+	begin = std::min(gameCount, blocks * worker / rangeCount * RANGE_ALIGNMENT);
+	end = std::min(gameCount, blocks * (worker + 1) / rangeCount * RANGE_ALIGNMENT);
+}
+
+void BatchSim::work(uint32_t worker) {
+	while (true) {
+		startBarrier.arrive_and_wait();
+		if (isStopping)
+			return;
+		uint32_t begin, end;
+		range(worker, begin, end);
+		stepRange(begin, end, pendingActions);
+		endBarrier.arrive_and_wait();
+	}
+}
+
+void BatchSim::step(const Action* actions) {
+	++stepCount;
+	if (workers.empty()) {
+		stepRange(0, gameCount, actions);
+		return;
+	}
+	pendingActions = actions;
+	startBarrier.arrive_and_wait();
+	uint32_t begin, end;
+	range(0, begin, end);
+	stepRange(begin, end, actions);
+	endBarrier.arrive_and_wait();
+}
+
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "Cell.h"
+#include "Rng.h"
+#include "Simulation.h"
+
+#include <barrier>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace sim {
+
+struct BatchSettings {
+	uint32_t gameCount = 1024;
+	int32_t gridSize = 20;
+	// game i draws its apples from stream i of this seed
+	uint64_t seed = 1;
+	// 0 for one per hardware thread
+	uint32_t threadCount = 0;
+	// the kernels for the grid sizes of the settings are compiled for that size, false takes the generic ones for any size
+	bool isSpecialized = true;
+};
+
+// Many games of the same grid size stepped together, for training and balancing tools. Same rules as sim::step.
+//
+// Structure of arrays: heads, directions, lengths etc. are one array each, so that the per tick work is a few
+// branch free loops over contiguous memory that the compiler vectorizes. Bodies are not lists of cells:
+// every cell stores the tick at which a head last entered it, and a cell belongs to the snake while
+// tick - entered < length. A move is then a single store, growing is just length + 1, and the tail needs no bookkeeping.
+//
+// Games are split into contiguous ranges, one per worker thread. A game that ends restarts right away (auto reset),
+// its outcome for that step tells how it ended.
+class BatchSim {
+private:
+	uint32_t gameCount;
+	int32_t gridSize;
+	uint32_t cellCount;
+	// the layout of the grid kernels: cells of a row are consecutive, rows rowPitch apart, indexCount per game
+	uint32_t rowPitch{};
+	uint32_t indexCount{};
+	// turn, advance and wall check for the grid size, chosen at construction
+	using AdvanceHeads = void (*)(uint32_t begin, uint32_t end, int32_t size, uint32_t indices, const Action* actions, uint8_t* dir,
+		const int32_t* hx, const int32_t* hy, int32_t* nx, int32_t* ny, uint32_t* tick, uint32_t* next);
+	AdvanceHeads advance = nullptr;
+
+	std::vector<int32_t> headX;
+	std::vector<int32_t> headY;
+	std::vector<uint8_t> dirs; // Direction
+	std::vector<uint32_t> lengths;
+	std::vector<uint32_t> scores;
+	std::vector<int32_t> appleX;
+	std::vector<int32_t> appleY;
+	// per game clock, jumps ahead on a reset so that the cells of the previous game read as empty
+	std::vector<uint32_t> ticks;
+	// indexCount per game, tick at which the head entered the cell
+	std::vector<uint32_t> entered;
+	std::vector<Rng> rngs;
+	std::vector<Outcome> outcomes;
+	// scratch between the passes of a step: next head and its cell index, UINT32_MAX for a wall
+	std::vector<int32_t> nextX;
+	std::vector<int32_t> nextY;
+	std::vector<uint32_t> nextCell;
+	uint64_t stepCount{};
+
+	// workers beyond the calling thread, which takes the first range itself
+	std::vector<std::thread> workers;
+	std::barrier<> startBarrier;
+	std::barrier<> endBarrier;
+	const Action* pendingActions = nullptr;
+	bool isStopping = false;
+private:
+	inline uint32_t toIndex(uint32_t game, int32_t x, int32_t y) const { return game * indexCount + static_cast<uint32_t>(y) * rowPitch + static_cast<uint32_t>(x); }
+	// index of the game's grid
+	bool isFree(uint32_t game, uint32_t index) const;
+	bool placeApple(uint32_t game);
+	void reset(uint32_t game);
+	void stepRange(uint32_t begin, uint32_t end, const Action* actions);
+	void range(uint32_t worker, uint32_t& begin, uint32_t& end) const;
+	void work(uint32_t worker);
+public:
+	BatchSim(const BatchSettings& settings);
+	BatchSim(const BatchSim& other) = delete;
+	BatchSim& operator=(const BatchSim& other) = delete;
+	~BatchSim();
+
+	// one tick of every game, actions[game]
+	void step(const Action* actions);
+
+	uint32_t getGameCount() const { return gameCount; }
+	int32_t getGridSize() const { return gridSize; }
+	uint32_t getThreadCount() const { return static_cast<uint32_t>(workers.size()) + 1; }
+	// outcome of each game in the last step
+	const Outcome* getOutcomes() const { return outcomes.data(); }
+	Cell getHead(uint32_t game) const { return { headX[game], headY[game] }; }
+	Direction getDirection(uint32_t game) const { return static_cast<Direction>(dirs[game]); }
+	uint32_t getLength(uint32_t game) const { return lengths[game]; }
+	uint32_t getScore(uint32_t game) const { return scores[game]; }
+	Cell getApple(uint32_t game) const { return { appleX[game], appleY[game] }; }
+	bool isSnake(uint32_t game, const Cell& cell) const;
+	uint64_t getStepCount() const { return stepCount; }
+};
+
+}
@@ -0,0 +1,81 @@
+#include "BoardTexture.h"
+
+#include <Profiler.h>
+
+#include <algorithm>
+
+uint32_t BoardTexture::getColor(const sim::State& state, const Cell& cell) {
+	if (state.hasApple && cell.isSameAs(state.apple))
+		return APPLE_COLOR;
+	return state.snake.getGrid().isSnake(cell) ? SNAKE_COLOR : EMPTY_COLOR;
+}
+
+bool BoardTexture::reserve(int32_t gridSize) {
+	invalidate();
+	if (gridSize > MAX_GRID_SIZE) {
+		texture.reset();
+		this->gridSize = 0;
+		return false;
+	}
+	if (!texture || this->gridSize != gridSize) {
+		texture = std::make_unique<gds::StreamingTexture>(gridSize, gridSize);
+		this->gridSize = gridSize;
+	}
+	return texture->isValid();
+}
+
+bool BoardTexture::isReserved(int32_t gridSize) const {
+	return texture && texture->isValid() && this->gridSize == gridSize;
+}
+
+void BoardTexture::invalidate() {
+	isCurrent = false;
+}
+
+void BoardTexture::redraw(const sim::State& state) {
+	GDS_PROFILE_ZONE("BoardTexture::redraw");
+	int pitch = 0;
+	uint32_t* pixels = texture->lock({ 0, 0, gridSize, gridSize }, pitch);
+	if (pixels == nullptr)
+		return;
+	for (int32_t y = 0; y < gridSize; ++y)
+		std::fill_n(pixels + static_cast<size_t>(y) * pitch, gridSize, EMPTY_COLOR);
+	state.snake.getGrid().forEachSnakeCell({ 0, 0, gridSize, gridSize }, [&](const Cell& cell) {
+		pixels[static_cast<size_t>(cell.y) * pitch + cell.x] = SNAKE_COLOR;
+	});
+	if (state.hasApple)
+		pixels[static_cast<size_t>(state.apple.y) * pitch + state.apple.x] = APPLE_COLOR;
+	texture->unlock();
+}
+
+void BoardTexture::updateCell(const sim::State& state, const Cell& cell) {
+	if (!state.snake.getGrid().isWall(cell))
+		texture->setPixel(cell.x, cell.y, getColor(state, cell));
+}
+
+void BoardTexture::update(const sim::State& state) {
+	const Snake& snake = state.snake;
+	if (isCurrent && state.ticks == ticks)
+		return;
+	// a tick forward or back changes only these cells, before and after
+	if (isCurrent && (state.ticks == ticks + 1 || state.ticks + 1 == ticks)) {
+		for (const Cell& cell : { head, tail, apple, snake.getHead(), snake.getTail(), state.apple })
+			updateCell(state, cell);
+	} else {
+		redraw(state);
+	}
+
+	isCurrent = true;
+	ticks = state.ticks;
+	head = snake.getHead();
+	tail = snake.getTail();
+	apple = state.apple;
+}
+
+void BoardTexture::render(const Camera& camera) {
+	const CellRect cells = camera.getVisibleCells();
+	const float side = camera.getCellPixels();
+	const SDL_Rect src{ cells.x, cells.y, cells.width, cells.height };
+	const SDL_FRect dst{ camera.toScreenX(static_cast<float>(cells.x)), camera.toScreenY(static_cast<float>(cells.y)), cells.width * side, cells.height * side };
+	texture->render(src, dst);
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Camera.h"
+#include "Cell.h"
+#include "Simulation.h"
+
+#include <gds.h>
+
+#include <cstdint>
+#include <memory>
+
+// The board as a streaming texture with one texel per cell, drawn with a single nearest filtered copy.
+//
+// A tick rewrites only the texels it can have changed: the cells the head, the tail and the apple were on before and are
+// on now. Anything else, a restart, a load, a seek or several ticks between two frames, redraws the whole texture.
+// The cost of a frame does not depend on the length of the snake.
+class BoardTexture {
+public:
+	// larger grids get no texture and are drawn cell by cell
+	static constexpr int32_t MAX_GRID_SIZE = 2048;
+
+	static constexpr uint32_t EMPTY_COLOR = 0x888888FF;
+	static constexpr uint32_t SNAKE_COLOR = 0x000000FF;
+	static constexpr uint32_t APPLE_COLOR = 0xAA0000FF;
+
+private:
+	std::unique_ptr<gds::StreamingTexture> texture;
+	int32_t gridSize{};
+	// the game as the texture shows it
+	bool isCurrent = false;
+	uint64_t ticks{};
+	Cell head;
+	Cell tail;
+	Cell apple;
+
+private:
+	static uint32_t getColor(const sim::State& state, const Cell& cell);
+	void redraw(const sim::State& state);
+	void updateCell(const sim::State& state, const Cell& cell);
+
+public:
+	// Creates the texture for the grid, false if the grid is larger than MAX_GRID_SIZE.
+	// Allocates, to be called between frames. The next update() redraws.
+	bool reserve(int32_t gridSize);
+	bool isReserved(int32_t gridSize) const;
+	// the next update() redraws everything, for changes to the game other than a tick
+	void invalidate();
+
+	// brings the texture up to date with state, whose grid has to be the reserved one
+	void update(const sim::State& state);
+	// the part of the board the camera sees, over the whole screen
+	void render(const Camera& camera);
+};
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Cell.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+// Square window onto a square grid. Grids up to maxVisibleCells per side are shown whole, larger ones
+// at maxVisibleCells per side around a followed point, stopping at the edges of the grid.
+class Camera {
+private:
+	int32_t gridSize{};
+	int32_t visibleCells{};
+	float cellPixels{};
+	// top left corner of the window, in cells
+	float left{};
+	float top{};
+
+public:
+	Camera(int32_t gridSize, int32_t screenPixels, int32_t maxVisibleCells)
+		: gridSize(gridSize), visibleCells(std::min(gridSize, maxVisibleCells)), cellPixels(static_cast<float>(screenPixels) / visibleCells) {}
+
+	// centers the window on the middle of cell (x, y), fractional for a cell on its way to the next one
+	void follow(float x, float y) {
+		const float maxCorner = static_cast<float>(gridSize - visibleCells);
+		left = std::clamp(x + 0.5f - visibleCells * 0.5f, 0.0f, maxCorner);
+		top = std::clamp(y + 0.5f - visibleCells * 0.5f, 0.0f, maxCorner);
+	}
+
+	float getCellPixels() const { return cellPixels; }
+	float toScreenX(float x) const { return (x - left) * cellPixels; }
+	float toScreenY(float y) const { return (y - top) * cellPixels; }
+
+	// cells that are at least partly on screen
+	CellRect getVisibleCells() const {
+		const int32_t x = static_cast<int32_t>(std::floor(left));
+		const int32_t y = static_cast<int32_t>(std::floor(top));
+		const int32_t size = visibleCells + 1;
+		return { x, y, std::min(size, gridSize - x), std::min(size, gridSize - y) };
+	}
+	// upper bound of getVisibleCells() width and height, for sizing buffers
+	int32_t getMaxVisibleCells() const { return visibleCells + 1; }
+};
@@ -7,35 +7,36 @@ enum class Direction {
 	UP = 0, RIGHT = 1, DOWN = 2, LEFT = 3
 };
 
+// x and y steps of a move per Direction, UP is +y
+inline constexpr int32_t DIRECTION_DX[4] = { 0, 1, 0, -1 };
+inline constexpr int32_t DIRECTION_DY[4] = { 1, 0, -1, 0 };
+
 class Cell {
 public:
 	int32_t x{};
 	int32_t y{};
 
 public:
-	static Cell deltaCell(Direction dir) {
-		switch (dir) {
-		case Direction::UP:
-			return Cell{ 0, 1 };
-		case Direction::RIGHT:
-			return Cell{ 1, 0 };
-		case Direction::DOWN:
-			return Cell{ 0, -1 };
-		case Direction::LEFT:
-			return Cell{ -1, 0 };
-		}
-		assert(false); // unknown direction
+	// a table lookup rather than a switch, directions are 0..3
+	static constexpr Cell deltaCell(Direction dir) {
+		const uint32_t ix = static_cast<uint32_t>(dir);
+		assert(ix < 4); // unknown direction
+		return Cell{ DIRECTION_DX[ix & 3], DIRECTION_DY[ix & 3] };
 	}
 
-	Cell addCell(const Cell& other) const {
+	constexpr Cell addCell(const Cell& other) const {
 		return Cell{ x + other.x, y + other.y };
 	}
 
-	bool isSameAs(const Cell& other) const {
+	constexpr bool isSameAs(const Cell& other) const {
 		return x == other.x && y == other.y;
 	}
+};
 
-	bool isAtGridWalls(int gridSize) const {
-		return x == -1 || x == gridSize || y == -1 || y == gridSize;
-	}
+// cells [x, x + width) x [y, y + height)
+struct CellRect {
+	int32_t x{};
+	int32_t y{};
+	int32_t width{};
+	int32_t height{};
 };
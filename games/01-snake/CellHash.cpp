@@ -0,0 +1,63 @@
+#include "CellHash.h"
+
+#include <algorithm>
+#include <bit>
+#include <utility>
+
+CellHash::CellHash(size_t expectedCount) {
+	rehash(std::bit_ceil(std::max<size_t>(16, expectedCount * 2)));
+}
+
+void CellHash::rehash(size_t slotCount) {
+	std::vector<Slot> previous = std::exchange(slots, std::vector<Slot>(slotCount));
+	mask = slotCount - 1;
+	shift = 64 - static_cast<uint32_t>(std::countr_zero(slotCount));
+	count = 0;
+	for (const Slot& slot : previous)
+		if (slot.key != EMPTY_KEY)
+			insert(Cell{ static_cast<int32_t>(slot.key & 0xFFFFFFFFu), static_cast<int32_t>(slot.key >> 32) }, slot.value);
+}
+
+void CellHash::reserve(size_t expectedCount) {
+	if (expectedCount * 2 > slots.size())
+		rehash(std::bit_ceil(expectedCount * 2));
+}
+
+void CellHash::clear() {
+	std::fill(slots.begin(), slots.end(), Slot{});
+	count = 0;
+}
+
+void CellHash::insert(const Cell& cell, uint32_t value) {
+	if ((count + 1) * 2 > slots.size())
+		rehash(slots.size() * 2);
+	const uint64_t key = toKey(cell);
+	size_t ix = getHome(key);
+	while (slots[ix].key != EMPTY_KEY && slots[ix].key != key)
+		ix = (ix + 1) & mask;
+	if (slots[ix].key == EMPTY_KEY)
+		++count;
+	slots[ix] = Slot{ key, value };
+}
+
+bool CellHash::erase(const Cell& cell) {
+	const uint64_t key = toKey(cell);
+	size_t hole = getHome(key);
+	while (slots[hole].key != key) {
+		if (slots[hole].key == EMPTY_KEY)
+			return false;
+		hole = (hole + 1) & mask;
+	}
+	// Backward shift: an entry after the hole moves into it unless its home lies between the hole and the entry,
+	// then no probe sequence runs through an empty slot before reaching its entry
+	for (size_t ix = (hole + 1) & mask; slots[ix].key != EMPTY_KEY; ix = (ix + 1) & mask) {
+		const size_t home = getHome(slots[ix].key);
+		if (((ix - home) & mask) >= ((ix - hole) & mask)) {
+			slots[hole] = slots[ix];
+			hole = ix;
+		}
+	}
+	slots[hole] = Slot{};
+	--count;
+	return true;
+}
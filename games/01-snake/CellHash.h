@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Cell.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Map from cells to uint32_t values for sparse sets of cells, memory follows the entries rather than the area.
+// Open addressing with linear probing in a power of two table that is kept at most half full. Erasing shifts the
+// following entries back instead of leaving tombstones, so probes stay short however many cells come and go.
+class CellHash {
+public:
+	static constexpr uint32_t NOT_FOUND = UINT32_MAX;
+
+private:
+	static constexpr uint64_t EMPTY_KEY = UINT64_MAX;
+
+	struct Slot {
+		uint64_t key = EMPTY_KEY;
+		uint32_t value{};
+	};
+
+	std::vector<Slot> slots;
+	size_t mask{};
+	// 64 - log2 of the table size, the high bits of the product are the home slot
+	uint32_t shift{};
+	size_t count{};
+
+private:
+	static inline uint64_t toKey(const Cell& cell) {
+		return (static_cast<uint64_t>(static_cast<uint32_t>(cell.y)) << 32) | static_cast<uint32_t>(cell.x);
+	}
+	// Fibonacci hashing, neighbouring cells land far apart
+	inline size_t getHome(uint64_t key) const { return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> shift); }
+	void rehash(size_t slotCount);
+
+public:
+	CellHash(size_t expectedCount = 16);
+
+	size_t size() const { return count; }
+	// room for count entries without growing
+	void reserve(size_t expectedCount);
+	void clear();
+
+	uint32_t find(const Cell& cell) const {
+		const uint64_t key = toKey(cell);
+		for (size_t ix = getHome(key);; ix = (ix + 1) & mask) {
+			const Slot& slot = slots[ix];
+			if (slot.key == key)
+				return slot.value;
+			if (slot.key == EMPTY_KEY)
+				return NOT_FOUND;
+		}
+	}
+	// adds the cell or overwrites its value
+	void insert(const Cell& cell, uint32_t value);
+	// false if the cell was not there
+	bool erase(const Cell& cell);
+};
@@ -0,0 +1,28 @@
+#include "FreeCellSet.h"
+
+FreeCellSet::FreeCellSet(int32_t gridSize)
+	: gridSize{ gridSize }, freeCells(static_cast<size_t>(gridSize) * gridSize), positions(static_cast<size_t>(gridSize) * gridSize) {
+	for (int32_t ix = 0; ix < static_cast<int32_t>(freeCells.size()); ++ix) {
+		freeCells[ix] = ix;
+		positions[ix] = ix;
+	}
+}
+
+void FreeCellSet::insert(const Cell& cell) {
+	const int32_t ix = toIndex(cell);
+	assert(positions[ix] == NOT_FREE);
+	positions[ix] = static_cast<int32_t>(freeCells.size());
+	// never reallocates, capacity is the whole grid since construction
+	freeCells.push_back(ix);
+}
+
+void FreeCellSet::remove(const Cell& cell) {
+	const int32_t ix = toIndex(cell);
+	const int32_t pos = positions[ix];
+	assert(pos != NOT_FREE);
+	const int32_t last = freeCells.back();
+	freeCells[pos] = last;
+	positions[last] = pos;
+	freeCells.pop_back();
+	positions[ix] = NOT_FREE;
+}
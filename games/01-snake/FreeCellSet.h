@@ -0,0 +1,42 @@
+#pragma once
+
+#include "Cell.h"
+#include "Rng.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Set of the free cells of the play area as a dense array plus a position index per cell.
+// Insertion appends, removal swaps with the last element, and a uniformly random free cell is a single lookup.
+class FreeCellSet {
+private:
+	static constexpr int32_t NOT_FREE = -1;
+
+	int32_t gridSize{};
+	// cell indices (y * gridSize + x) of free cells, in no particular order
+	std::vector<int32_t> freeCells;
+	// for every cell its position in freeCells, or NOT_FREE
+	std::vector<int32_t> positions;
+
+private:
+	inline int32_t toIndex(const Cell& cell) const { return cell.y * gridSize + cell.x; }
+	inline Cell toCell(int32_t ix) const { return Cell{ ix % gridSize, ix / gridSize }; }
+
+public:
+	// every cell starts free
+	FreeCellSet(int32_t gridSize);
+
+	inline size_t size() const { return freeCells.size(); }
+	inline bool isEmpty() const { return freeCells.empty(); }
+	inline bool contains(const Cell& cell) const { return positions[toIndex(cell)] != NOT_FREE; }
+
+	void insert(const Cell& cell);
+	void remove(const Cell& cell);
+
+	// set must not be empty
+	Cell sample(Rng& rng) const {
+		assert(!isEmpty());
+		return toCell(freeCells[rng.nextBelow(static_cast<uint32_t>(freeCells.size()))]);
+	}
+};
@@ -0,0 +1,147 @@
+#include "Game.h"
+
+#include <AllocationTracker.h>
+#include <gds.h>
+#include <Profiler.h>
+
+#include <iostream>
+
+const int SIZE = 800;
+
+//------------- Game
+
+Game::Game(const gds::LoopSettings& settings) : settings(settings), timestep(settings) {
+	if (settings.vsync)
+		gds::sdl.setVsync(true);
+}
+
+void Game::handleEvent(const SDL_Event& e) {
+	if (e.type == SDL_QUIT)
+		quit = true;
+	else if (e.type == SDL_WINDOWEVENT)
+		state->setDirty(true); // exposed, resized, restored etc.
+#ifdef GDS_PROFILING
+	else if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_F3)
+		showFrameGraph = !showFrameGraph;
+#endif
+	else
+		state->handleEvent(e);
+}
+
+bool Game::isAllocationChecked() const {
+	return state == stateManager.playingState.get() && playingFrames > ALLOCATION_WARMUP_FRAMES && stateManager.playingState->isAllocationFree();
+}
+
+void Game::runFrame() {
+	SDL_Event e;
+
+	// Nothing new to show on a static screen: block until an event arrives instead of spinning.
+	// The timeout only bounds how long a missed wake-up could stall.
+	// Headless runs have no one waiting for input, they render every frame at full speed instead.
+	const bool isIdle = !state->isDirty() && !gds::sdl.isHeadless();
+	if (isIdle) {
+		GDS_PROFILE_ZONE("Game::waitEvent");
+		if (SDL_WaitEventTimeout(&e, IDLE_WAIT_MS))
+			handleEvent(e);
+		timestep.skipElapsed();
+	}
+	{
+		GDS_PROFILE_ZONE("Game::pollEvents");
+		while (SDL_PollEvent(&e))
+			handleEvent(e);
+	}
+
+	// State Manager, simulated in fixed steps regardless of the frame rate
+	timestep.beginFrame();
+	{
+		GDS_PROFILE_ZONE("Game::update");
+		while (timestep.consumeStep()) {
+			State* next;
+			{
+				// switching to another state may allocate, entering it is outside the scope
+				gds::NoAllocationScope noAllocations{ "PlayingState::update", isAllocationChecked() };
+				next = state->update(settings.stepMs);
+			}
+			++updateCount;
+			if (next != state) {
+				next->enter();
+				next->setDirty(true);
+			}
+			state = next;
+		}
+	}
+
+	if (!state->isDirty() && !gds::sdl.isHeadless()) {
+		GDS_PROFILE_FRAME();
+		return;
+	}
+
+	{
+		GDS_PROFILE_ZONE("Game::render");
+		SDL_SetRenderDrawColor(gds::sdl.renderer, 0xFF, 0x00, 0xFF, 0xFF);
+		SDL_RenderClear(gds::sdl.renderer);
+
+		{
+			gds::NoAllocationScope noAllocations{ "PlayingState::render", isAllocationChecked() };
+			state->render(timestep.getAlpha());
+		}
+		state->setDirty(false);
+		if (state == stateManager.playingState.get())
+			++playingFrames;
+#ifdef GDS_PROFILING
+		if (showFrameGraph)
+			gds::profiler.renderFrameGraph({ 10, SIZE - 110, 256, 100 });
+#endif
+	}
+
+	gds::sdl.renderPresent();
+	{
+		GDS_PROFILE_ZONE("Game::endFrame");
+		timestep.endFrame();
+	}
+	GDS_PROFILE_FRAME();
+}
+
+void Game::run() {
+	// time spent between construction and the first frame is not simulated
+	timestep.skipElapsed();
+	while (!quit)
+		runFrame();
+
+	std::cout << "frames: " << timestep.getFrameCount()
+		<< ", frame time mean: " << timestep.getFrameTimeMeanMs() << " ms"
+		<< ", std dev: " << timestep.getFrameTimeStdDevMs() << " ms\n";
+#ifdef GDS_PROFILING
+	gds::profiler.exportChromeTrace("gds_trace.json");
+#endif
+}
+
+bool Game::startReplay(const std::string& path) {
+	PlayingState* playingState = stateManager.playingState.get();
+	if (!playingState->startReplay(path))
+		return false;
+	state = playingState;
+	state->enter();
+	state->setDirty(true);
+	return true;
+}
+
+bool Game::isQuitting() const {
+	return quit;
+}
+
+State* Game::getState() const {
+	return state;
+}
+
+StateManager& Game::getStateManager() {
+	return stateManager;
+}
+
+const gds::FixedTimestep& Game::getTimestep() const {
+	return timestep;
+}
+
+uint64_t Game::getUpdateCount() const {
+	return updateCount;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "GameStates.h"
+
+#include <FixedTimestep.h>
+
+#include <SDL.h>
+
+#include <cstdint>
+#include <string>
+
+// Owns the state machine and runs the loop: events, fixed step updates, render and present.
+class Game {
+private:
+	StateManager stateManager;
+	State* state = stateManager.menuState.get();
+	gds::LoopSettings settings;
+	gds::FixedTimestep timestep;
+	bool quit = false;
+	uint64_t updateCount{};
+	// frames rendered in the playing state, it may allocate while warming up (glyph atlas etc.)
+	uint64_t playingFrames{};
+	static constexpr uint64_t ALLOCATION_WARMUP_FRAMES = 120;
+	static constexpr int IDLE_WAIT_MS = 500;
+#ifdef GDS_PROFILING
+	bool showFrameGraph = false;
+#endif
+public:
+	Game(const gds::LoopSettings& settings);
+
+	void handleEvent(const SDL_Event& e);
+	// in the allocation tracker's assert mode, the playing state must not allocate after warmup, arena games aside
+	bool isAllocationChecked() const;
+	// one pass of the loop, drivers such as the scenario runner call this instead of run()
+	void runFrame();
+	// runs frames until quit, then prints frame time statistics
+	void run();
+	// shows a recorded game instead of the main menu, false if it can't be read
+	bool startReplay(const std::string& path);
+
+	bool isQuitting() const;
+	State* getState() const;
+	StateManager& getStateManager();
+	const gds::FixedTimestep& getTimestep() const;
+	// fixed step updates since construction
+	uint64_t getUpdateCount() const;
+};
@@ -1,14 +1,21 @@
 #include "GameStates.h"
+#include "Camera.h"
 
 #include <gds.h>
+#include <Profiler.h>
 #include "Widgets.h"
 
 #include <algorithm>
+#include <charconv>
+#include <ctime>
+#include <filesystem>
 #include <iostream>
 #include <random>
 #include <string>
 
 const int SIZE = 800;
+// larger grids are shown in part, the camera follows the head
+const int32_t MAX_VISIBLE_CELLS = 40;
 
 //------------- MenuState
 
@@ -59,7 +66,8 @@ MenuState::MenuState(StateManager& stateManager)
 			static const std::string SMALL = "Small";
 			static const std::string MEDIUM = "Medium";
 			static const std::string LARGE = "Large";
-			gds::Selector& sizeSelector = settingsPage.addSelector("Area Size", { SMALL, MEDIUM, LARGE }, 1);
+			static const std::string HUGE_SIZE = "Huge";
+			gds::Selector& sizeSelector = settingsPage.addSelector("Area Size", { SMALL, MEDIUM, LARGE, HUGE_SIZE }, 1);
 			auto callback = [&]() {
 				int32_t& size = stateManager.playingState->gridSize;
 				const std::string& selected = sizeSelector.getSelection();
@@ -69,10 +77,23 @@ MenuState::MenuState(StateManager& stateManager)
 					size = 20;
 				else if (selected == LARGE)
 					size = 40;
+				else if (selected == HUGE_SIZE)
+					size = 10000;
 			};
 			sizeSelector.registerCallback(callback);
 		}
 
+		// Mode
+		{
+			static const std::string CLASSIC = "Classic";
+			static const std::string ARENA = "Arena";
+			gds::Selector& modeSelector = settingsPage.addSelector("Mode", { CLASSIC, ARENA }, 0);
+			auto callback = [&]() {
+				stateManager.playingState->isArena = modeSelector.getSelection() == ARENA;
+			};
+			modeSelector.registerCallback(callback);
+		}
+
 		// Speed
 		{
 			static const std::string SLOW = "Slow";
@@ -109,6 +130,9 @@ MenuState::MenuState(StateManager& stateManager)
 				"Controls:"
 				"\nLEFT ARROW turns the snake to the left"
 				"\nRIGHT ARROW turns the snake to the right"
+				"\nBACKSPACE rewinds a few moves"
+				"\nA switches the autopilot on and off"
+				"\nF5 saves the game, F9 loads it"
 				"\nESC pauses the game", 
 				gds::sdl.getFont(gds::DEFAULT_FONT), { 0xCC, 0x22, 0x33 }, {200, 250});
 		}
@@ -127,8 +151,7 @@ MenuState::MenuState(StateManager& stateManager)
 }
 
 void MenuState::handleEvent(const SDL_Event& e) {
-	if (e.type == SDL_KEYDOWN && e.key.repeat == 0)
-		lastKey = e.key.keysym.sym;
+	input.push(e);
 }
 
 State* MenuState::update(uint32_t deltaTime) {
@@ -137,141 +160,461 @@ State* MenuState::update(uint32_t deltaTime) {
 	if (nextState) {
 		result = nextState;
 		nextState = nullptr;
+		input.clear();
 		return result;
 	}
-		
-	menu.handleKeys(lastKey);
-	lastKey = SDLK_UNKNOWN;
+
+	// every press in order, until one leaves the menu
+	const uint32_t now = SDL_GetTicks();
+	while (!input.isEmpty() && nextState == nullptr) {
+		dirty = true;
+		menu.handleKeys(input.pop(now).key);
+	}
 
 	return result;
 }
 
-void MenuState::render() {
+void MenuState::render(float) {
 	SDL_SetRenderDrawColor(gds::sdl.renderer, 0x88, 0x88, 0x88, 0xFF);
 	SDL_RenderClear(gds::sdl.renderer);
 
 	menu.render();
 
-	gds::renderText("Hungry Snake", { 0xCC, 0x22, 0x33 }, SIZE / 2, 200, gds::sdl.getFont(gds::TITLE_FONT).get(), true);
+	gds::renderText("Hungry Snake", { 0xCC, 0x22, 0x33 }, SIZE / 2, 200, gds::sdl.getFont(gds::TITLE_FONT), true);
 }
 
 
 //------------- PlayingState
 
 
-PlayingState::PlayingState(StateManager& stateManager) : State(stateManager), lastKey{ SDLK_UNKNOWN }, snake{ Cell{gridSize / 2, gridSize / 2}, 2, Direction::LEFT } {
-	for (const Cell& cell : snake.getCells())
-		assert(!cell.isAtGridWalls(gridSize));
-	placeApple();
+PlayingState::PlayingState(StateManager& stateManager)
+	: State(stateManager), simulation{ gridSize, Rng{ std::random_device{}() } } {
+	for (const Cell& cell : simulation.snake.getCells())
+		assert(!simulation.snake.getGrid().isWall(cell));
+	reserveBatch();
+}
+
+PlayingState::~PlayingState() {
+	endRecording();
 }
 
 void PlayingState::handleEvent(const SDL_Event& e) {
-	if (e.type == SDL_KEYDOWN && e.key.repeat == 0)
-		lastKey = e.key.keysym.sym;
+	if (e.type != SDL_KEYDOWN)
+		return;
+	// seeking restores a keyframe, which allocates: done here rather than in update
+	if (replayPlayer && (e.key.keysym.sym == SDLK_LEFT || e.key.keysym.sym == SDLK_RIGHT)) {
+		const uint64_t tick = replayPlayer->getTick();
+		constexpr uint64_t SEEK_TICKS = 50;
+		replayPlayer->seek(e.key.keysym.sym == SDLK_LEFT ? tick - std::min(tick, SEEK_TICKS) : tick + SEEK_TICKS);
+		board.invalidate();
+		timer = 0;
+		return;
+	}
+	if (!replayPlayer && !arena && e.key.keysym.sym == SDLK_F5) {
+		// grows with the snake, here rather than in update
+		quickSave.resize(std::max(quickSave.size(), sim::getSnapshotSize(simulation)));
+		quickSaveSize = sim::saveSnapshot(simulation, timer, quickSave);
+		return;
+	}
+	if (!replayPlayer && !arena && e.key.keysym.sym == SDLK_F9) {
+		quickLoad();
+		return;
+	}
+	if (!replayPlayer && !arena && e.key.keysym.sym == SDLK_a && e.key.repeat == 0) {
+		// the distance field is sized here rather than in update
+		isAutopilot = !isAutopilot;
+		if (isAutopilot)
+			autopilot.reserve(simulation.snake.getGrid().getGridSize());
+		return;
+	}
+	input.push(e);
+}
+
+void PlayingState::quickLoad() {
+	if (quickSaveSize == 0)
+		return;
+	// the loaded game goes on in a new timeline, the recording and the history end here
+	endRecording();
+	rewind.clear();
+	sim::loadSnapshot({ quickSave.data(), quickSaveSize }, simulation, timer);
+	input.clear();
+	reserveBatch();
+	if (isAutopilot)
+		autopilot.reserve(simulation.snake.getGrid().getGridSize());
+}
+
+const sim::State& PlayingState::getSimulation() const {
+	return replayPlayer ? replayPlayer->getState() : simulation;
+}
+
+int32_t PlayingState::getTickPeriod() const {
+	return replayPlayer ? replay.getHeader().period : period;
+}
+
+void PlayingState::endRecording() {
+	// restarting from the game over screen and again from the menu would leave empty recordings
+	if (simulation.ticks == 0)
+		recorder.discard();
+	else
+		recorder.end(simulation);
 }
 
 void PlayingState::placeApple() {
-	const int32_t numCells = gridSize * gridSize;
-	std::vector<Cell> availableCells{};
-	availableCells.reserve(numCells);
-	std::vector<Cell> out; // a vector, not a single cell because of std::sample API
-	for (int32_t i = 0; i < numCells; ++i) {
-		Cell cell{ i % gridSize , i / gridSize };
-		if (!snake.hasCell(cell))
-			availableCells.push_back(cell);
-	}
-	if (availableCells.size() == 0) {
+	if (!sim::placeApple(simulation))
 		std::cout << "CONGRATULATIONS: Longest snake!\n";
+}
+
+void PlayingState::seed(uint32_t value) {
+	simulation.rng.seed(value);
+}
+
+uint64_t PlayingState::getTickCount() const {
+	return tickCount;
+}
+
+bool PlayingState::isAllocationFree() const {
+	return arena == nullptr;
+}
+
+const gds::InputQueue& PlayingState::getInput() const {
+	return input;
+}
+
+void PlayingState::restart() {
+	// a game left through the pause menu ends here
+	endRecording();
+	replayPlayer.reset();
+	replayFile.close();
+
+	// the random sequence goes on, a seed given before the restart decides the new game
+	simulation = sim::State{ gridSize, simulation.rng };
+	rewind.clear();
+	// turns queued in the last game would steer the new one, the arena too
+	input.clear();
+	reserveBatch();
+	if (isAutopilot)
+		autopilot.reserve(gridSize);
+
+	arena.reset();
+	if (isArena) {
+		// a snake and an apple per 32 cells, up to a few hundred
+		const uint64_t area = static_cast<uint64_t>(gridSize) * gridSize;
+		const uint32_t snakeCount = static_cast<uint32_t>(std::clamp<uint64_t>(area / 32, 4, 400));
+		sim::ArenaSettings settings;
+		settings.gridSize = gridSize;
+		settings.snakeCount = snakeCount;
+		settings.appleCount = snakeCount;
+		settings.seed = simulation.rng.next();
+		arena = std::make_unique<sim::Arena>(settings);
+		arenaActions.assign(snakeCount, sim::Action::NONE);
+		arenaFocus = arena->getSnake(0).isAlive ? arena->getSnake(0).cells.front() : Cell{ gridSize / 2, gridSize / 2 };
+		// arena games are not recorded
 		return;
 	}
-	std::sample(availableCells.begin(), availableCells.end(), std::back_inserter(out), 1, rnd);
-	apple = out[0];
+
+	if (!replayDirectory.empty()) {
+		const std::string name = "snake-" + std::to_string(std::time(nullptr)) + "-" + std::to_string(++recordingCount) + ".gdsr";
+		recorder.begin((std::filesystem::path{ replayDirectory } / name).string(), simulation, period);
+	}
 }
 
-void PlayingState::restart() {
-	score = 0;
-	snake = Snake{ Cell{gridSize / 2, gridSize / 2}, 2, Direction::LEFT };
-	placeApple();
+void PlayingState::setReplayDirectory(const std::string& directory) {
+	replayDirectory = directory;
+	std::error_code error;
+	if (!directory.empty())
+		std::filesystem::create_directories(directory, error);
+}
+
+bool PlayingState::startReplay(const std::string& path) {
+	// a replay is not recorded again
+	endRecording();
+	replayPlayer.reset();
+	if (!replayFile.open(path) || !replay.open(replayFile.getBytes()))
+		return false;
+	replayPlayer = std::make_unique<sim::ReplayPlayer>(replay);
+	timer = 0;
+	input.clear();
+	reserveBatch();
+	return true;
+}
+
+bool PlayingState::isReplaying() const {
+	return replayPlayer != nullptr;
 }
 
-void PlayingState::render() {
+void PlayingState::reserveBatch() {
+	// a screen full of snake, the apple and the two interpolated parts
+	const Camera camera{ getSimulation().snake.getGrid().getGridSize(), SIZE, MAX_VISIBLE_CELLS };
+	const size_t cells = static_cast<size_t>(camera.getMaxVisibleCells());
+	batch.reserve(cells * cells + 3);
+	if (useBoardTexture)
+		board.reserve(getSimulation().snake.getGrid().getGridSize());
+}
+
+void PlayingState::render(float alpha) {
+	GDS_PROFILE_ZONE("PlayingState::render");
 	// Clear
 	SDL_SetRenderDrawColor(gds::sdl.renderer, 0x88, 0x88, 0x88, 0xFF);
 	SDL_RenderClear(gds::sdl.renderer);
 
-	// Render Game Area
-	const float rectSide = static_cast<float>(SIZE) / gridSize;
+	if (arena) {
+		renderArena();
+		renderScore(arena->getSnake(0).score);
+		return;
+	}
 
-	{
-		SDL_SetRenderDrawColor(gds::sdl.renderer, 0xAA, 0x00, 0x00, 0xFF);
-		const SDL_FRect rect = { apple.x * rectSide, apple.y * rectSide, rectSide, rectSide };
-		SDL_RenderFillRectF(gds::sdl.renderer, &rect);
+	// Render Game Area
+	const sim::State& current = getSimulation();
+	const Snake& snake = current.snake;
+	const Cell& apple = current.apple;
+	const SDL_Color snakeColor{ 0x00, 0x00, 0x00, 0xFF };
+
+	// Interpolate towards the next tick: the head slides into the next cell, the tail slides out of its cell.
+	// Only when the next tick is a plain move in the current direction, otherwise the snake jumps at the tick.
+	const Cell nextCell = snake.getNextCell();
+	const bool isTurning = replayPlayer ? replayPlayer->peekAction() != sim::Action::NONE : !input.isEmpty();
+	const bool isPlainMove = !isTurning && snake.getGrid().isEmpty(nextCell) && !nextCell.isSameAs(apple) && snake.getCells().size() > 1;
+	const float progress = isPlainMove ? std::min(1.0f, (timer + alpha * lastDeltaTime) / getTickPeriod()) : 0.0f;
+
+	// the camera moves with the sliding head, so that it glides rather than jumps a cell per tick
+	const Cell delta = Cell::deltaCell(snake.getDirection());
+	Camera camera{ snake.getGrid().getGridSize(), SIZE, MAX_VISIBLE_CELLS };
+	camera.follow(snake.getHead().x + delta.x * progress, snake.getHead().y + delta.y * progress);
+	const float rectSide = camera.getCellPixels();
+
+	// The board is a texture with a texel per cell, updated where the last tick changed it and copied in one call.
+	// Otherwise the apple and the visible part of the snake go out in a single draw call, found in the occupancy grid
+	// rather than by walking the body. Either way the cost follows the screen and not the length of the snake.
+	const bool isBoardTexture = useBoardTexture && board.isReserved(snake.getGrid().getGridSize());
+	if (isBoardTexture) {
+		board.update(current);
+		board.render(camera);
+	}
+	if (current.hasApple) {
+		const float x = camera.toScreenX(static_cast<float>(apple.x));
+		const float y = camera.toScreenY(static_cast<float>(apple.y));
+		if (x > -rectSide && x < SIZE && y > -rectSide && y < SIZE) {
+			if (!isBoardTexture)
+				batch.addRect({ x, y, rectSide, rectSide }, { 0xAA, 0x00, 0x00, 0xFF });
+		} else {
+			// off screen, a marker on the edge points toward it
+			const float marker = rectSide / 2;
+			batch.addRect({ std::clamp(x, 0.0f, SIZE - marker), std::clamp(y, 0.0f, SIZE - marker), marker, marker }, { 0xAA, 0x00, 0x00, 0xFF });
+		}
+	}
+	if (!isBoardTexture) {
+		snake.getGrid().forEachSnakeCell(camera.getVisibleCells(), [&](const Cell& cell) {
+			batch.addRect({ camera.toScreenX(static_cast<float>(cell.x)), camera.toScreenY(static_cast<float>(cell.y)), rectSide, rectSide }, snakeColor);
+		});
 	}
 
-	SDL_SetRenderDrawColor(gds::sdl.renderer, 0x00, 0x00, 0x00, 0xFF);
-	for (const Cell& cell : snake.getCells()) {
-		const SDL_FRect rect = { cell.x * rectSide, cell.y * rectSide, rectSide, rectSide };
-		SDL_RenderFillRectF(gds::sdl.renderer, &rect);
+	if (isPlainMove) {
+		const float offset = progress * rectSide;
+
+		const SDL_FRect headPart = {
+			camera.toScreenX(static_cast<float>(nextCell.x)) + (delta.x < 0 ? rectSide - offset : 0.0f),
+			camera.toScreenY(static_cast<float>(nextCell.y)) + (delta.y < 0 ? rectSide - offset : 0.0f),
+			delta.x != 0 ? offset : rectSide,
+			delta.y != 0 ? offset : rectSide };
+		batch.addRect(headPart, snakeColor);
+
+		// paint background over the part of the tail cell that is already left
+		const Cell& tail = snake.getTail();
+		const Cell& beforeTail = snake.getCells()[snake.getCells().size() - 2];
+		const Cell toward{ beforeTail.x - tail.x, beforeTail.y - tail.y };
+		const SDL_FRect tailPart = {
+			camera.toScreenX(static_cast<float>(tail.x)) + (toward.x < 0 ? rectSide - offset : 0.0f),
+			camera.toScreenY(static_cast<float>(tail.y)) + (toward.y < 0 ? rectSide - offset : 0.0f),
+			toward.x != 0 ? offset : rectSide,
+			toward.y != 0 ? offset : rectSide };
+		batch.addRect(tailPart, { 0x88, 0x88, 0x88, 0xFF });
 	}
+	batch.flush();
 
-	// Render texts such as score
-	{
-		TTF_Font* font = gds::sdl.getFont(gds::DEFAULT_FONT).get();
-		std::string text = "score: " + std::to_string(score);
-		gds::renderText(text, { 0xCC, 0xCC, 0xCC }, 0, 0, font);
+	renderScore(current.score);
+}
+
+void PlayingState::renderArena() {
+	// the visible cells are looked up in the arena's index, the cost follows the screen rather than the snakes
+	Camera camera{ arena->getGridSize(), SIZE, MAX_VISIBLE_CELLS };
+	camera.follow(static_cast<float>(arenaFocus.x), static_cast<float>(arenaFocus.y));
+	const float rectSide = camera.getCellPixels();
+	const CellRect visible = camera.getVisibleCells();
+	static constexpr SDL_Color BOT_COLORS[] = { { 0x22, 0x22, 0x88, 0xFF }, { 0x22, 0x66, 0x22, 0xFF }, { 0x66, 0x22, 0x66, 0xFF }, { 0x66, 0x55, 0x11, 0xFF } };
+	for (int32_t y = visible.y; y < visible.y + visible.height; ++y) {
+		for (int32_t x = visible.x; x < visible.x + visible.width; ++x) {
+			const uint32_t occupant = arena->getOccupant({ x, y });
+			if (occupant == sim::Arena::EMPTY)
+				continue;
+			const SDL_Color color = (occupant & sim::Arena::APPLE_FLAG) ? SDL_Color{ 0xAA, 0x00, 0x00, 0xFF }
+				: occupant == 0 ? SDL_Color{ 0x00, 0x00, 0x00, 0xFF } : BOT_COLORS[occupant % std::size(BOT_COLORS)];
+			batch.addRect({ camera.toScreenX(static_cast<float>(x)), camera.toScreenY(static_cast<float>(y)), rectSide, rectSide }, color);
+		}
 	}
+	batch.flush();
+}
+
+void PlayingState::renderScore(uint32_t score) {
+	gds::Font& font = gds::sdl.getFont(gds::DEFAULT_FONT);
+	// formatted on the stack, rendering a frame does not allocate
+	char text[32] = "score: ";
+	const std::to_chars_result formatted = std::to_chars(text + 7, text + sizeof(text), score);
+	gds::renderText(std::string_view(text, formatted.ptr - text), { 0xCC, 0xCC, 0xCC }, 0, 0, font);
 }
 
 State* PlayingState::update(uint32_t deltaTime) {
 	State* result = this;
 
+	lastDeltaTime = deltaTime;
 	timer += deltaTime;
-	if (timer < period)
+	if (timer < getTickPeriod())
 		return result;
-	timer -= period;
+	timer -= getTickPeriod();
+	GDS_PROFILE_ZONE("PlayingState::tick");
+	++tickCount;
 
-	switch (lastKey) {
-	case SDLK_LEFT:
-		snake.turnLeft();
-		break;
-	case SDLK_RIGHT:
-		snake.turnRight();
-		break;
+	if (replayPlayer)
+		return updateReplay();
+	if (arena)
+		return updateArena();
+
+	sim::Action action = sim::Action::NONE;
+	switch (takeTickInput(action)) {
 	case SDLK_ESCAPE:
-		lastKey = SDLK_UNKNOWN;
 		result = stateManager.pauseState.get();
 		return result;
-	case SDLK_UNKNOWN:
+	case SDLK_BACKSPACE: {
+		// a replay can't go back in time, the recording ends before the rewind
+		endRecording();
+		constexpr int REWIND_TICKS = 10;
+		for (int ix = 0; ix < REWIND_TICKS && rewind.stepBack(simulation); ++ix) {}
+		board.invalidate();
+		return result;
+	}
+	default:
 		break;
 	}
-	lastKey = SDLK_UNKNOWN;
-
-	const Cell& nextCell = snake.getNextCell();
-	if (nextCell.isAtGridWalls(gridSize)) {
-		GameOverState& gameOver = *stateManager.gameOverState;
-		result = &gameOver;
-		gameOver.setGameOverReason("(Snake hit the wall.)");
+	// a turn of the player takes the snake back, the autopilot follows the game after a rewind or a load by itself
+	if (action != sim::Action::NONE)
+		isAutopilot = false;
+	else if (isAutopilot)
+		action = autopilot.choose(simulation);
+
+	recorder.recordStep(simulation, action);
+	rewind.capture(simulation);
+	const sim::Outcome outcome = sim::step(simulation, action);
+	rewind.commit(simulation);
+	switch (outcome) {
+	case sim::Outcome::HIT_WALL:
+		stateManager.gameOverState->setGameOverReason("(Snake hit the wall.)");
+		result = stateManager.gameOverState.get();
+		recorder.end(simulation);
+		break;
+	case sim::Outcome::BIT_ITSELF:
+		stateManager.gameOverState->setGameOverReason("(Snake bit itself.)");
+		result = stateManager.gameOverState.get();
+		recorder.end(simulation);
+		break;
+	case sim::Outcome::ATE_APPLE:
+		recorder.recordApple(simulation);
+		if (!simulation.hasApple)
+			std::cout << "CONGRATULATIONS: Longest snake!\n";
+		break;
+	case sim::Outcome::MOVED:
+		break;
 	}
-	else if (snake.willBiteItself(nextCell)) {
-		GameOverState& gameOver = *stateManager.gameOverState;
-		result = &gameOver;
-		gameOver.setGameOverReason("(Snake bit itself.)");
+
+	return result;
+}
+
+SDL_Keycode PlayingState::takeTickInput(sim::Action& action) {
+	const uint32_t now = SDL_GetTicks();
+	for (uint32_t turns = 0; !input.isEmpty() && turns < std::max(turnsPerTick, 1u);) {
+		const SDL_Keycode key = input.front().key;
+		if (turns > 0 && (key == SDLK_ESCAPE || key == SDLK_BACKSPACE))
+			break;
+		input.pop(now);
+		switch (key) {
+		case SDLK_LEFT:
+			action = sim::Action::TURN_LEFT;
+			++turns;
+			break;
+		case SDLK_RIGHT:
+			action = sim::Action::TURN_RIGHT;
+			++turns;
+			break;
+		case SDLK_ESCAPE:
+		case SDLK_BACKSPACE:
+			return key;
+		default:
+			break;
+		}
 	}
-	else if (nextCell.isSameAs(apple)) {
-		snake.elongate();
-		placeApple();
-		++score;
+	return SDLK_UNKNOWN;
+}
+
+State* PlayingState::updateArena() {
+	arenaActions[0] = sim::Action::NONE;
+	// no rewinds in the arena, BACKSPACE is ignored
+	if (takeTickInput(arenaActions[0]) == SDLK_ESCAPE)
+		return stateManager.pauseState.get();
+	for (uint32_t snake = 1; snake < arena->getSnakeCount(); ++snake)
+		arenaActions[snake] = sim::chooseBotAction(*arena, snake, botRng);
+
+	arena->step(arenaActions.data());
+	switch (arena->getOutcomes()[0]) {
+	case sim::ArenaOutcome::HIT_WALL:
+		stateManager.gameOverState->setGameOverReason("(Snake hit the wall.)");
+		return stateManager.gameOverState.get();
+	case sim::ArenaOutcome::BIT_ITSELF:
+		stateManager.gameOverState->setGameOverReason("(Snake bit itself.)");
+		return stateManager.gameOverState.get();
+	case sim::ArenaOutcome::HIT_SNAKE:
+		stateManager.gameOverState->setGameOverReason("(Snake ran into another snake.)");
+		return stateManager.gameOverState.get();
+	case sim::ArenaOutcome::HEAD_ON:
+		stateManager.gameOverState->setGameOverReason("(Snakes met head on.)");
+		return stateManager.gameOverState.get();
+	case sim::ArenaOutcome::NOT_PLAYING:
+		stateManager.gameOverState->setGameOverReason("(No room in the arena.)");
+		return stateManager.gameOverState.get();
+	case sim::ArenaOutcome::MOVED:
+	case sim::ArenaOutcome::ATE_APPLE:
+		break;
 	}
-	else
-		snake.move();
+	arenaFocus = arena->getSnake(0).cells.front();
+	return this;
+}
 
-	return result;
+State* PlayingState::updateReplay() {
+	// the recording has the turns, the player's are ignored
+	sim::Action ignored = sim::Action::NONE;
+	if (takeTickInput(ignored) == SDLK_ESCAPE)
+		return stateManager.pauseState.get();
+
+	switch (replayPlayer->tick()) {
+	case sim::Outcome::HIT_WALL:
+		stateManager.gameOverState->setGameOverReason("(Snake hit the wall.)");
+		return stateManager.gameOverState.get();
+	case sim::Outcome::BIT_ITSELF:
+		stateManager.gameOverState->setGameOverReason("(Snake bit itself.)");
+		return stateManager.gameOverState.get();
+	case sim::Outcome::ATE_APPLE:
+	case sim::Outcome::MOVED:
+		break;
+	}
+	// the player left the recorded game
+	if (replayPlayer->isFinished()) {
+		stateManager.gameOverState->setGameOverReason("(Replay ended.)");
+		return stateManager.gameOverState.get();
+	}
+	return this;
 }
 
 
 //------------- PauseState
 
-PauseState::PauseState(StateManager& stateManager) : State(stateManager), pausePage({SIZE / 2, SIZE / 2}), menu(pausePage) {
+PauseState::PauseState(StateManager& stateManager) : State(stateManager), background(SIZE, SIZE), pausePage({SIZE / 2, SIZE / 2}), menu(pausePage) {
 	// Resume Button
 	{
 		gds::Button& resumeButton = pausePage.addButton("Resume");
@@ -292,9 +635,13 @@ PauseState::PauseState(StateManager& stateManager) : State(stateManager), pauseP
 }
 
 void PauseState::handleEvent(const SDL_Event& e) {
-	if (e.type == SDL_KEYDOWN && e.key.repeat == 0)
-		lastKey = e.key.keysym.sym;
-	if (lastKey == SDLK_ESCAPE)
+	// render targets lose their content when the renderer resets them or the device
+	if (e.type == SDL_RENDER_TARGETS_RESET || e.type == SDL_RENDER_DEVICE_RESET) {
+		isCaptureLost = true;
+		dirty = true;
+	}
+	input.push(e);
+	if (e.type == SDL_KEYDOWN && e.key.repeat == 0 && e.key.keysym.sym == SDLK_ESCAPE)
 		nextState = stateManager.playingState.get();
 }
 
@@ -305,18 +652,25 @@ State* PauseState::update(uint32_t deltaTime) {
 	if (nextState) {
 		result = nextState;
 		nextState = nullptr;
+		input.clear();
 		return result;
 	}
 
-	menu.handleKeys(lastKey);
-	lastKey = SDLK_UNKNOWN;
+	// every press in order, until one leaves the pause menu
+	const uint32_t now = SDL_GetTicks();
+	while (!input.isEmpty() && nextState == nullptr) {
+		dirty = true;
+		menu.handleKeys(input.pop(now).key);
+	}
 
 	return result;
 }
 
-void PauseState::render() {
+void PauseState::enter() {
+	background.beginCapture();
+
 	// Render game area without evolving it
-	stateManager.playingState->render();
+	stateManager.playingState->render(0.0f);
 
 	// Draw a semi-transparent fullscreen quad overlay
 	SDL_SetRenderDrawColor(gds::sdl.renderer, 0x00, 0x00, 0x00, 0x55);
@@ -325,37 +679,55 @@ void PauseState::render() {
 	SDL_RenderFillRect(gds::sdl.renderer, &rect);
 	SDL_SetRenderDrawBlendMode(gds::sdl.renderer, SDL_BLENDMODE_NONE);
 
+	background.endCapture();
+}
+
+void PauseState::render(float) {
+	if (isCaptureLost) {
+		isCaptureLost = false;
+		enter();
+	}
+	// Frozen game area and overlay in a single copy
+	background.render({ 0, 0 });
+
 	// Pause rendering specific draw calls
 	menu.render();
 }
 
 //------------- GameOverState
 
-GameOverState::GameOverState(StateManager& stateManager) : State(stateManager) {}
+GameOverState::GameOverState(StateManager& stateManager) : State(stateManager), background(SIZE, SIZE) {}
 
-void GameOverState::setGameOverReason(const std::string& text) {
+void GameOverState::setGameOverReason(std::string_view text) {
 	gameOverReason = text;
 }
 
 void GameOverState::handleEvent(const SDL_Event& e) {
-	if (e.type == SDL_KEYDOWN && e.key.repeat == 0)
-		lastKey = e.key.keysym.sym;
+	if (e.type == SDL_RENDER_TARGETS_RESET || e.type == SDL_RENDER_DEVICE_RESET) {
+		isCaptureLost = true;
+		dirty = true;
+	}
+	input.push(e);
 }
 
 State* GameOverState::update(uint32_t deltaTime) {
 	State* result = this;
-	if (lastKey != SDLK_UNKNOWN) {
+	// any key, the ones after it are not for the menu
+	if (!input.isEmpty()) {
+		input.pop(SDL_GetTicks());
+		input.clear();
 		result = stateManager.menuState.get();
 		stateManager.playingState->restart();
 	}
-	lastKey = SDLK_UNKNOWN;
 
 	return result;
 }
 
-void GameOverState::render() {
+void GameOverState::enter() {
+	background.beginCapture();
+
 	// Render game area without evolving it
-	stateManager.playingState->render();
+	stateManager.playingState->render(0.0f);
 
 	// Draw a semi-transparent fullscreen quad overlay
 	SDL_SetRenderDrawColor(gds::sdl.renderer, 0x00, 0x00, 0x00, 0x99);
@@ -365,11 +737,21 @@ void GameOverState::render() {
 	SDL_SetRenderDrawBlendMode(gds::sdl.renderer, SDL_BLENDMODE_NONE);
 
 	// GameOver rendering specific draw calls
-	TTF_Font* font = gds::sdl.getFont(gds::DEFAULT_FONT).get();
+	gds::Font& font = gds::sdl.getFont(gds::DEFAULT_FONT);
 	gds::renderText("Game Over", { 0xCC, 0x22, 0x33 }, SIZE / 2, SIZE / 2, font, true);
-	gds::renderText(gameOverReason.c_str(), {0xCC, 0x22, 0x33}, SIZE / 2, SIZE / 2 + 30, font, true);
+	gds::renderText(gameOverReason, {0xCC, 0x22, 0x33}, SIZE / 2, SIZE / 2 + 30, font, true);
 	gds::renderText("Press any key to return to main menu", { 0xCC, 0x22, 0x33 }, SIZE / 2, SIZE - 30, font, true);
 
+	background.endCapture();
+}
+
+void GameOverState::render(float) {
+	if (isCaptureLost) {
+		isCaptureLost = false;
+		enter();
+	}
+	// Nothing on the game over screen changes after entering it
+	background.render({ 0, 0 });
 }
 
 //------------- StateManager
@@ -1,15 +1,25 @@
 #pragma once
 
+#include "Arena.h"
+#include "Autopilot.h"
+#include "BoardTexture.h"
 #include "Cell.h"
+#include "Replay.h"
+#include "Simulation.h"
+#include "Snapshot.h"
 #include "Snake.h"
 
+#include <InputQueue.h>
+#include <PrimitiveBatch.h>
 #include <Widgets.h>
 
 #include <SDL.h>
 #include <SDL_ttf.h>
 
 #include <memory>
-#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
 
 class State;
 class MenuState;
@@ -30,17 +40,27 @@ public:
 class State {
 protected:
 	StateManager& stateManager;
+	// output of a static state changed since the last render
+	bool dirty = true;
 public:
 	State(StateManager& stateManager) : stateManager(stateManager) {}
+	// Static states (menus, overlays) only change on input. They override this to report dirty or pending input,
+	// so that the loop can skip rendering and block on events while they are clean. Animated states are always dirty.
+	virtual bool isDirty() const { return true; }
+	void setDirty(bool isDirty) { dirty = isDirty; }
+
+	// called by the loop when the state becomes the current one
+	virtual void enter() {}
 	virtual void handleEvent(const SDL_Event& e) = 0;
 	virtual State* update(uint32_t deltaTime) = 0;
-	virtual void render() = 0;
+	// alpha is the fraction of an update step that elapsed since the last update, for interpolation
+	virtual void render(float alpha) = 0;
 	virtual ~State() = default;
 };
 
 class MenuState : public State {
 private:
-	SDL_Keycode lastKey{};
+	gds::InputQueue input;
 	gds::MenuPage mainPage;
 	gds::MenuPage settingsPage;
 	gds::MenuPage helpPage;
@@ -49,68 +69,162 @@ private:
 
 public:
 	MenuState(StateManager& stateManager);
+	bool isDirty() const final { return dirty || !input.isEmpty() || nextState != nullptr; }
 	void handleEvent(const SDL_Event& e) final;
 	State* update(uint32_t deltaTime) final;
-	void render() final;
+	void render(float alpha) final;
 };
 
 class PlayingState : public State {
-private:
-	SDL_Keycode lastKey;
-	Snake snake;
-	Cell apple;
-	uint32_t score{};
-	uint32_t timer{};
-	std::mt19937 rnd = std::mt19937{ std::random_device{}() };
-	//State* state;
 public:
+	// declared before simulation, which is initialized with gridSize
 	int32_t gridSize{ 15 };
 	int32_t period = 200;
+	// the board as one streaming texture, grids too large for one are drawn as rects
+	bool useBoardTexture = true;
+	// from the next restart on: the player is one of many snakes, the others are bots
+	bool isArena = false;
+	// Turns a tick takes from the input queue, the last one it takes is the tick's action. 1 gives every press a tick
+	// of its own, more let the last press of a quick burst win.
+	uint32_t turnsPerTick = 1;
+
+private:
+	// presses since the last tick, ticks take them in order
+	gds::InputQueue input;
+	// rules and state of the game, this class maps keys to actions and draws the result
+	sim::State simulation;
+	uint32_t timer{};
+	uint32_t lastDeltaTime{};
+	uint64_t tickCount{};
+	gds::PrimitiveBatch batch;
+	BoardTexture board;
+	//State* state;
+
+	// every game is recorded into this folder, empty for none
+	std::string replayDirectory;
+	uint32_t recordingCount{};
+	sim::ReplayWriter recorder;
+	// set while a recorded game is shown instead of played
+	sim::MappedFile replayFile;
+	sim::Replay replay;
+	std::unique_ptr<sim::ReplayPlayer> replayPlayer;
+	// recent ticks for BACKSPACE
+	sim::RewindBuffer rewind;
+	// F5 saves here, F9 loads. Grown on F5 to the size of the snapshot.
+	std::vector<uint8_t> quickSave;
+	size_t quickSaveSize{};
+	// set while an arena game is played, the player is snake 0
+	std::unique_ptr<sim::Arena> arena;
+	std::vector<sim::Action> arenaActions;
+	Rng botRng;
+	// the camera follows it, the player's head while alive
+	Cell arenaFocus;
+	// A hands the snake to the autopilot and back, an arrow key takes it back too
+	sim::Autopilot autopilot;
+	bool isAutopilot = false;
+
+private:
+	// the game on screen, played or replayed
+	const sim::State& getSimulation() const;
+	int32_t getTickPeriod() const;
+	// finishes the recording of the current game, drops it if the game never started
+	void endRecording();
+	// a tick of the replay instead of the game
+	State* updateReplay();
+	void quickLoad();
+	// The keys of one tick from the input queue: up to turnsPerTick turns into action. ESC and BACKSPACE end the tick's
+	// keys, after a turn they wait for the next tick. Returns the key that ended them, SDLK_UNKNOWN for none.
+	SDL_Keycode takeTickInput(sim::Action& action);
+	// a tick of the arena instead of the game
+	State* updateArena();
+	void renderArena();
+	void renderScore(uint32_t score);
 
 public:
 	PlayingState(StateManager& stateManager);
+	~PlayingState();
 
+	// ends a replay, starts a new game
 	void restart();
 
+	// records the games from the next restart on, created if missing
+	void setReplayDirectory(const std::string& directory);
+
+	// shows the recorded game in real time until restart(). LEFT and RIGHT seek, false if the file is not a replay.
+	bool startReplay(const std::string& path);
+	bool isReplaying() const;
+
+	// reseeds apple placement, for reproducible runs
+	void seed(uint32_t value);
+
 	void placeApple();
 
+	// the batch is sized for a screen full of snake and the board texture for the grid, rendering never grows them
+	void reserveBatch();
+
+	// snake moves since construction
+	uint64_t getTickCount() const;
+
+	// false in the arena, its snakes and index grow on the heap
+	bool isAllocationFree() const;
+
+	// input latency and dropped presses of the game
+	const gds::InputQueue& getInput() const;
+
 	void handleEvent(const SDL_Event& e)  final;
 
-	void render() final;
+	void render(float alpha) final;
 
 	State* update(uint32_t deltaTime) final;
 };
 
 class PauseState : public State {
 private:
+	// frozen game area with the overlay, captured on enter
+	gds::TargetTexture background;
+	// the renderer dropped the captured background, the next render captures it again
+	bool isCaptureLost = false;
 	gds::MenuPage pausePage;
 	gds::Menu menu;
-	SDL_Keycode lastKey{};
+	gds::InputQueue input;
 	State* nextState = nullptr;
 
 public:
 	PauseState(StateManager& stateManager);
 
+	bool isDirty() const final { return dirty || !input.isEmpty() || nextState != nullptr; }
+
+	void enter() final;
+
 	void handleEvent(const SDL_Event& e) final;
 
 	State* update(uint32_t deltaTime) final;
 
-	void render() final;
+	void render(float alpha) final;
 };
 
 class GameOverState : public State {
 private:
-	SDL_Keycode lastKey = SDLK_UNKNOWN;
-	std::string gameOverReason = "NO REASON GIVEN";
+	gds::InputQueue input;
+	// reasons are string literals, setting one does not allocate
+	std::string_view gameOverReason = "NO REASON GIVEN";
+	// the whole game over screen, captured on enter
+	gds::TargetTexture background;
+	bool isCaptureLost = false;
 
 public:
 	GameOverState(StateManager& stateManager);
 
-	void setGameOverReason(const std::string& text);
+	bool isDirty() const final { return dirty || !input.isEmpty(); }
+
+	void enter() final;
+
+	// text has to outlive the game over screen
+	void setGameOverReason(std::string_view text);
 
 	void handleEvent(const SDL_Event& e) final;
 
 	State* update(uint32_t deltaTime) final;
 
-	void render() final;
+	void render(float alpha) final;
 };
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "Cell.h"
+
+#include <bit>
+#include <cassert>
+#include <cstdint>
+
+// Geometry of a W x H play area fixed at compile time. Bounds checks compare against constants and rows are a power
+// of two apart, a cell index is a shift and an or. The indices past column W - 1 of a row are padding, no cell maps there.
+template<int32_t W, int32_t H>
+class Grid {
+public:
+	static_assert(W > 0 && H > 0, "a grid has cells");
+	static constexpr int32_t WIDTH = W;
+	static constexpr int32_t HEIGHT = H;
+	static constexpr uint32_t ROW_SHIFT = static_cast<uint32_t>(std::bit_width(static_cast<uint32_t>(W - 1)));
+	static constexpr uint32_t ROW_PITCH = 1u << ROW_SHIFT;
+
+public:
+	// the size is a template argument already, the parameters match DynamicGrid
+	constexpr Grid(int32_t width = W, int32_t height = H) {
+		assert(width == W && height == H);
+		(void)width;
+		(void)height;
+	}
+
+	static constexpr int32_t getWidth() { return W; }
+	static constexpr int32_t getHeight() { return H; }
+	static constexpr uint32_t getRowPitch() { return ROW_PITCH; }
+	// indices per grid, padding included
+	static constexpr uint32_t getIndexCount() { return ROW_PITCH * static_cast<uint32_t>(H); }
+
+	static constexpr bool isInside(const Cell& cell) {
+		// negative coordinates wrap to large unsigned ones
+		return static_cast<uint32_t>(cell.x) < static_cast<uint32_t>(W) && static_cast<uint32_t>(cell.y) < static_cast<uint32_t>(H);
+	}
+	static constexpr uint32_t toIndex(const Cell& cell) { return (static_cast<uint32_t>(cell.y) << ROW_SHIFT) | static_cast<uint32_t>(cell.x); }
+	static constexpr Cell toCell(uint32_t index) { return Cell{ static_cast<int32_t>(index & (ROW_PITCH - 1)), static_cast<int32_t>(index >> ROW_SHIFT) }; }
+};
+
+// The same interface for any size, known at runtime. Rows are packed, no padding.
+class DynamicGrid {
+private:
+	int32_t width{};
+	int32_t height{};
+
+public:
+	constexpr DynamicGrid(int32_t width, int32_t height) : width{ width }, height{ height } {}
+
+	constexpr int32_t getWidth() const { return width; }
+	constexpr int32_t getHeight() const { return height; }
+	constexpr uint32_t getRowPitch() const { return static_cast<uint32_t>(width); }
+	constexpr uint32_t getIndexCount() const { return static_cast<uint32_t>(width) * static_cast<uint32_t>(height); }
+
+	constexpr bool isInside(const Cell& cell) const {
+		return static_cast<uint32_t>(cell.x) < static_cast<uint32_t>(width) && static_cast<uint32_t>(cell.y) < static_cast<uint32_t>(height);
+	}
+	constexpr uint32_t toIndex(const Cell& cell) const { return static_cast<uint32_t>(cell.y) * static_cast<uint32_t>(width) + static_cast<uint32_t>(cell.x); }
+	constexpr Cell toCell(uint32_t index) const { return Cell{ static_cast<int32_t>(index % width), static_cast<int32_t>(index / width) }; }
+};
+
+static_assert(Grid<20, 20>::toIndex({ 3, 2 }) == 2 * 32 + 3 && Grid<20, 20>::toCell(2 * 32 + 3).isSameAs({ 3, 2 }));
+static_assert(!Grid<10, 10>::isInside({ -1, 0 }) && !Grid<10, 10>::isInside({ 0, 10 }) && Grid<10, 10>::isInside({ 9, 9 }));
+
+// Calls visit(grid) once with the Grid specialization for the sizes the settings offer (10, 20 and 40), with a
+// DynamicGrid for any other size. Callers dispatch when the size changes and keep what visit returns, a kernel
+// instantiated for the grid type, rather than dispatching per cell.
+template<typename Visit>
+decltype(auto) visitGrid(int32_t width, int32_t height, Visit&& visit) {
+	if (width == height) {
+		switch (width) {
+		case 10:
+			return visit(Grid<10, 10>{});
+		case 20:
+			return visit(Grid<20, 20>{});
+		case 40:
+			return visit(Grid<40, 40>{});
+		default:
+			break;
+		}
+	}
+	return visit(DynamicGrid{ width, height });
+}
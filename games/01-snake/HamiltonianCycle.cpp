@@ -0,0 +1,49 @@
+#include "HamiltonianCycle.h"
+
+namespace sim {
+
+//------------- HamiltonianCycle
+
+HamiltonianCycle::HamiltonianCycle(int32_t gridSize)
+	: gridSize(gridSize), size(static_cast<uint64_t>(gridSize) * gridSize - (gridSize % 2 == 0 ? 0 : 1)) {
+}
+
+uint64_t HamiltonianCycle::getPosition(const Cell& cell) const {
+	const uint64_t n = static_cast<uint64_t>(gridSize);
+	const uint64_t x = static_cast<uint64_t>(cell.x);
+	const uint64_t y = static_cast<uint64_t>(cell.y);
+	// column 0 is the way back down, (0, 0) starts the cycle
+	if (x == 0)
+		return y == 0 ? 0 : size - y;
+	if (gridSize % 2 == 0 || y + 2 < n)
+		return 1 + y * (n - 1) + (y % 2 == 0 ? x - 1 : n - 1 - x);
+	// odd grids: the top two rows column by column from the right, up and down in turns
+	const uint64_t start = 1 + (n - 2) * (n - 1);
+	if (x == n - 1)
+		return y + 2 == n ? start : start + 1;
+	const uint64_t column = n - 2 - x;
+	const bool isLower = y + 2 == n;
+	return start + 1 + 2 * column + ((column % 2 == 0) == isLower ? 0 : 1);
+}
+
+Direction HamiltonianCycle::getDirection(const Cell& cell) const {
+	if (cell.x == 0)
+		return cell.y == 0 ? Direction::RIGHT : Direction::DOWN;
+	if (gridSize % 2 == 0 || cell.y + 2 < gridSize) {
+		if (cell.y % 2 == 0)
+			return cell.x == gridSize - 1 ? Direction::UP : Direction::RIGHT;
+		if (cell.x == 1)
+			return cell.y == gridSize - 1 ? Direction::LEFT : Direction::UP;
+		return Direction::LEFT;
+	}
+	// odd grids, the top two rows: up the corner column, then up the even columns counted from it and down the odd ones
+	const bool isLower = cell.y + 2 == gridSize;
+	if (cell.x == gridSize - 1)
+		return isLower ? Direction::UP : Direction::LEFT;
+	const bool isGoingUp = (gridSize - 2 - cell.x) % 2 == 0;
+	if (isLower == isGoingUp)
+		return isGoingUp ? Direction::UP : Direction::DOWN;
+	return Direction::LEFT;
+}
+
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Cell.h"
+
+#include <cstdint>
+
+namespace sim {
+
+// A closed path through the grid: serpentine rows over columns 1..gridSize-1, back down column 0.
+// A snake that follows it never hits a wall or itself while it is shorter than the cycle.
+// Odd grids have no cycle through every cell. There the top two rows are walked column by column and the corner
+// (gridSize-1, gridSize-1) shares its position with (gridSize-2, gridSize-2), a lap goes through one of the two.
+class HamiltonianCycle {
+private:
+	int32_t gridSize{};
+	uint64_t size{};
+
+public:
+	HamiltonianCycle(int32_t gridSize = 0);
+
+	// positions on the cycle
+	inline uint64_t getSize() const { return size; }
+	uint64_t getPosition(const Cell& cell) const;
+	// steps along the cycle from one position to another
+	inline uint64_t getDistance(uint64_t from, uint64_t to) const { return to >= from ? to - from : to + size - from; }
+	// direction to the next cell of a lap, on odd grids through the corner (gridSize-1, gridSize-1)
+	Direction getDirection(const Cell& cell) const;
+};
+
+}
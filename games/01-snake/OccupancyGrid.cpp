@@ -0,0 +1,100 @@
+#include "OccupancyGrid.h"
+
+OccupancyGrid::OccupancyGrid(int32_t gridSize)
+	: gridSize{ gridSize }, chunksPerRow{ (gridSize + CHUNK_SIZE - 1) >> CHUNK_SHIFT },
+	chunkTable(static_cast<size_t>(chunksPerRow) * chunksPerRow, 0), chunks(1) {
+	// Every chunk of a small grid, a few of a huge one up front: the pool only grows when a long snake spans more
+	const size_t reserved = std::min<size_t>(chunkTable.size(), 64);
+	chunks.reserve(reserved + 1);
+	freeChunks.reserve(reserved);
+	if (static_cast<uint64_t>(gridSize) * gridSize <= FREE_CELL_SET_MAX_CELLS)
+		freeCells.emplace(gridSize);
+}
+
+Cell OccupancyGrid::sampleFree(Rng& rng) const {
+	assert(getFreeCount() > 0);
+	if (freeCells)
+		return freeCells->sample(rng);
+
+	// Rejection sampling: on a huge grid almost every cell is free, a few draws find one
+	const uint64_t cellCount = static_cast<uint64_t>(gridSize) * gridSize;
+	const auto toCell = [this](uint64_t ix) { return Cell{ static_cast<int32_t>(ix % gridSize), static_cast<int32_t>(ix / gridSize) }; };
+	uint64_t ix = 0;
+	for (int attempt = 0; attempt < 64; ++attempt) {
+		ix = rng.nextBelow(static_cast<uint32_t>(cellCount));
+		if (!hasSnake(toCell(ix)))
+			return toCell(ix);
+	}
+	// Crowded: a random rank among the free cells, found by the free counts of the chunks and then of the rows.
+	// As uniform as the draws, and the cost follows the number of chunks rather than the area.
+	uint64_t rank = rng.nextBelow(static_cast<uint32_t>(getFreeCount()));
+	for (int32_t chunkY = 0; chunkY < chunksPerRow; ++chunkY) {
+		const int32_t y0 = chunkY << CHUNK_SHIFT;
+		const int32_t height = std::min(CHUNK_SIZE, gridSize - y0);
+		for (int32_t chunkX = 0; chunkX < chunksPerRow; ++chunkX) {
+			const int32_t x0 = chunkX << CHUNK_SHIFT;
+			const int32_t width = std::min(CHUNK_SIZE, gridSize - x0);
+			const Chunk& chunk = chunks[chunkTable[static_cast<size_t>(chunkY) * chunksPerRow + chunkX]];
+			const uint64_t chunkFree = static_cast<uint64_t>(width) * height - chunk.count;
+			if (rank >= chunkFree) {
+				rank -= chunkFree;
+				continue;
+			}
+			const uint64_t columns = width == CHUNK_SIZE ? ~0ull : (1ull << width) - 1;
+			for (int32_t y = 0; y < height; ++y) {
+				uint64_t bits = ~chunk.rows[y] & columns;
+				const uint64_t rowFree = static_cast<uint64_t>(std::popcount(bits));
+				if (rank >= rowFree) {
+					rank -= rowFree;
+					continue;
+				}
+				for (; rank > 0; --rank)
+					bits &= bits - 1;
+				return Cell{ x0 + std::countr_zero(bits), y0 + y };
+			}
+		}
+	}
+	// not reached, the rank is below the free count
+	assert(false);
+	return Cell{};
+}
+
+void OccupancyGrid::set(const Cell& cell, Content content) {
+	assert(content != Content::WALL && isInside(cell));
+	const bool isSnakeCell = content == Content::SNAKE;
+	if (hasSnake(cell) == isSnakeCell)
+		return;
+
+	uint32_t& chunkIndex = chunkTable[toChunkIndex(cell)];
+	if (chunkIndex == 0) {
+		// only setting a snake cell gets here, empty chunks have no snake cells to clear
+		if (freeChunks.empty()) {
+			chunkIndex = static_cast<uint32_t>(chunks.size());
+			chunks.emplace_back();
+		}
+		else {
+			chunkIndex = freeChunks.back();
+			freeChunks.pop_back();
+		}
+	}
+	Chunk& chunk = chunks[chunkIndex];
+	const uint64_t bit = 1ull << (cell.x & (CHUNK_SIZE - 1));
+	if (isSnakeCell) {
+		chunk.rows[cell.y & (CHUNK_SIZE - 1)] |= bit;
+		++chunk.count;
+		++snakeCount;
+		if (freeCells)
+			freeCells->remove(cell);
+	}
+	else {
+		chunk.rows[cell.y & (CHUNK_SIZE - 1)] &= ~bit;
+		--snakeCount;
+		if (freeCells)
+			freeCells->insert(cell);
+		// all zero again, back to the shared empty chunk
+		if (--chunk.count == 0) {
+			freeChunks.push_back(chunkIndex);
+			chunkIndex = 0;
+		}
+	}
+}
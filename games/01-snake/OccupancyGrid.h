@@ -0,0 +1,106 @@
+#pragma once
+
+#include "Cell.h"
+#include "FreeCellSet.h"
+#include "Rng.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+// Snake cells of the play area as bits in 64x64 chunks. Chunks exist only where the snake is: a chunk table
+// maps every chunk position to its chunk, empty ones share an all zero chunk, so queries do not branch on it.
+// Memory grows with the snake rather than the area, a 10000x10000 grid costs a 100 KB table.
+// Cells outside the play area are walls, every query is an O(1) lookup.
+class OccupancyGrid {
+public:
+	enum class Content : uint8_t {
+		EMPTY = 0, SNAKE = 1, WALL = 2
+	};
+
+	static constexpr int32_t CHUNK_SHIFT = 6;
+	static constexpr int32_t CHUNK_SIZE = 1 << CHUNK_SHIFT;
+	// up to this many cells the free cells are kept in a FreeCellSet for exact sampling, beyond it they are rejection sampled
+	static constexpr uint64_t FREE_CELL_SET_MAX_CELLS = 1 << 20;
+
+private:
+	struct Chunk {
+		// bit x of rows[y]
+		uint64_t rows[CHUNK_SIZE]{};
+		uint32_t count{};
+	};
+	static_assert(CHUNK_SIZE == 64, "a chunk row is one uint64_t");
+
+	int32_t gridSize{};
+	int32_t chunksPerRow{};
+	uint64_t snakeCount{};
+	// per chunk position the index into chunks, 0 for the shared empty chunk
+	std::vector<uint32_t> chunkTable;
+	// chunks[0] is the empty chunk and is never written
+	std::vector<Chunk> chunks;
+	std::vector<uint32_t> freeChunks;
+	// EMPTY cells of the play area, updated incrementally by set(). Only for grids up to FREE_CELL_SET_MAX_CELLS.
+	std::optional<FreeCellSet> freeCells;
+
+private:
+	inline bool isInside(const Cell& cell) const {
+		// negative coordinates wrap to large unsigned ones
+		return static_cast<uint32_t>(cell.x) < static_cast<uint32_t>(gridSize) && static_cast<uint32_t>(cell.y) < static_cast<uint32_t>(gridSize);
+	}
+	inline size_t toChunkIndex(const Cell& cell) const {
+		return static_cast<size_t>(cell.y >> CHUNK_SHIFT) * chunksPerRow + (cell.x >> CHUNK_SHIFT);
+	}
+	inline bool hasSnake(const Cell& cell) const {
+		return (chunks[chunkTable[toChunkIndex(cell)]].rows[cell.y & (CHUNK_SIZE - 1)] >> (cell.x & (CHUNK_SIZE - 1))) & 1;
+	}
+
+public:
+	OccupancyGrid(int32_t gridSize);
+
+	inline int32_t getGridSize() const { return gridSize; }
+
+	inline Content get(const Cell& cell) const { return !isInside(cell) ? Content::WALL : hasSnake(cell) ? Content::SNAKE : Content::EMPTY; }
+	inline bool isWall(const Cell& cell) const { return !isInside(cell); }
+	inline bool isSnake(const Cell& cell) const { return isInside(cell) && hasSnake(cell); }
+	inline bool isEmpty(const Cell& cell) const { return isInside(cell) && !hasSnake(cell); }
+
+	uint64_t getFreeCount() const { return static_cast<uint64_t>(gridSize) * gridSize - snakeCount; }
+	// uniformly random free cell, there has to be one
+	Cell sampleFree(Rng& rng) const;
+
+	// cell has to be inside the play area, walls can't be changed
+	void set(const Cell& cell, Content content);
+
+	// calls visit(cell) for the snake cells inside area, chunk by chunk and row by row.
+	// Empty chunks are skipped and a row of a chunk is one bit scan, the cost follows the area rather than the snake.
+	template<typename Visit>
+	void forEachSnakeCell(const CellRect& area, Visit&& visit) const {
+		const int32_t left = std::max(area.x, 0);
+		const int32_t top = std::max(area.y, 0);
+		const int32_t right = std::min(area.x + area.width, gridSize);
+		const int32_t bottom = std::min(area.y + area.height, gridSize);
+		for (int32_t chunkY = top >> CHUNK_SHIFT; chunkY <= (bottom - 1) >> CHUNK_SHIFT && top < bottom; ++chunkY) {
+			for (int32_t chunkX = left >> CHUNK_SHIFT; chunkX <= (right - 1) >> CHUNK_SHIFT && left < right; ++chunkX) {
+				const Chunk& chunk = chunks[chunkTable[static_cast<size_t>(chunkY) * chunksPerRow + chunkX]];
+				if (chunk.count == 0)
+					continue;
+				const int32_t x0 = chunkX << CHUNK_SHIFT;
+				const int32_t y0 = chunkY << CHUNK_SHIFT;
+				// bits of the columns of the chunk inside the area
+				const int32_t from = std::max(left - x0, 0);
+				const int32_t to = std::min(right - x0, CHUNK_SIZE);
+				const uint64_t columns = (to - from == 64 ? ~0ull : ((1ull << (to - from)) - 1)) << from;
+				for (int32_t y = std::max(top, y0); y < std::min(bottom, y0 + CHUNK_SIZE); ++y) {
+					uint64_t bits = chunk.rows[y - y0] & columns;
+					while (bits != 0) {
+						visit(Cell{ x0 + std::countr_zero(bits), y });
+						bits &= bits - 1;
+					}
+				}
+			}
+		}
+	}
+};
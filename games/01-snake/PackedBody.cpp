@@ -0,0 +1,60 @@
+#include "PackedBody.h"
+
+#include <utility>
+
+PackedBody::PackedBody(const Cell& head, size_t minCapacity) : head(head), tail(head) {
+	// whole words of links, a power of two of them
+	size_t links = LINKS_PER_WORD;
+	while (links + 1 < minCapacity)
+		links *= 2;
+	words.resize(links / LINKS_PER_WORD);
+	mask = links - 1;
+}
+
+void PackedBody::setLink(uint64_t pos, Direction dir) {
+	const uint64_t wrapped = pos & mask;
+	uint64_t& word = words[wrapped / LINKS_PER_WORD];
+	const uint32_t shift = static_cast<uint32_t>(wrapped % LINKS_PER_WORD * 2);
+	word = (word & ~(uint64_t{ 3 } << shift)) | (static_cast<uint64_t>(dir) << shift);
+}
+
+void PackedBody::grow() {
+	// twice the links
+	PackedBody larger{ head, (mask + 1) * 2 + 1 };
+	for (uint64_t pos = firstLink; pos != endLink; ++pos)
+		larger.setLink(larger.endLink++, static_cast<Direction>(getLink(pos)));
+	larger.tail = tail;
+	*this = std::move(larger);
+}
+
+void PackedBody::pushHead(Direction dir) {
+	if (endLink - firstLink == mask + 1)
+		grow();
+	setLink(endLink++, dir);
+	head = head.addCell(Cell::deltaCell(dir));
+}
+
+void PackedBody::pushTail(const Cell& cell) {
+	if (endLink - firstLink == mask + 1)
+		grow();
+	// from the new tail toward the old one
+	const int32_t dx = tail.x - cell.x;
+	const int32_t dy = tail.y - cell.y;
+	assert(dx * dx + dy * dy == 1); // neighbours only
+	const Direction dir = dx > 0 ? Direction::RIGHT : dx < 0 ? Direction::LEFT : dy > 0 ? Direction::UP : Direction::DOWN;
+	setLink(--firstLink, dir);
+	tail = cell;
+}
+
+void PackedBody::popTail() {
+	if (firstLink == endLink)
+		return;
+	tail = tail.addCell(Cell::deltaCell(static_cast<Direction>(getLink(firstLink++))));
+}
+
+void PackedBody::popHead() {
+	if (firstLink == endLink)
+		return;
+	const Cell delta = Cell::deltaCell(static_cast<Direction>(getLink(--endLink)));
+	head = Cell{ head.x - delta.x, head.y - delta.y };
+}
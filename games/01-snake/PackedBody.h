@@ -0,0 +1,118 @@
+#pragma once
+
+#include "Cell.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+// Compact snake body for very long snakes: the head and the tail cell, and between them a chain of 2 bit directions,
+// 32 links to a uint64_t. A segment costs 2 bits instead of the 64 of a Cell.
+//
+// Link i is the direction from segment i to its neighbour nearer the head, links run from the tail to the head.
+// They sit in a ring of words, so a tick pushes a link at the head and pops one at the tail, no shifting.
+// Cells are decoded on the fly from the head backwards. Membership is not answered here, see OccupancyGrid.
+class PackedBody {
+private:
+	static constexpr uint64_t LINKS_PER_WORD = 32;
+	static constexpr int32_t DELTA_X[4] = { 0, 1, 0, -1 };
+	static constexpr int32_t DELTA_Y[4] = { 1, 0, -1, 0 };
+
+	std::vector<uint64_t> words;
+	// running link positions, wrapped with the mask on access. Links [firstLink, endLink) are the body.
+	uint64_t firstLink{};
+	uint64_t endLink{};
+	uint64_t mask{};
+	Cell head;
+	Cell tail;
+
+private:
+	inline uint32_t getLink(uint64_t pos) const {
+		const uint64_t wrapped = pos & mask;
+		return static_cast<uint32_t>(words[wrapped / LINKS_PER_WORD] >> (wrapped % LINKS_PER_WORD * 2)) & 3;
+	}
+	void setLink(uint64_t pos, Direction dir);
+	void grow();
+
+public:
+	class Iterator {
+	private:
+		const PackedBody* body = nullptr;
+		// links below pos are still to be decoded, firstLink - 1 is past the tail
+		uint64_t pos{};
+		Cell cell;
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = Cell;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const Cell*;
+		using reference = const Cell&;
+
+		Iterator() = default;
+		Iterator(const PackedBody* body, uint64_t pos, const Cell& cell) : body(body), pos(pos), cell(cell) {}
+
+		reference operator*() const { return cell; }
+		pointer operator->() const { return &cell; }
+		Iterator& operator++() {
+			if (pos == body->firstLink) {
+				// past the tail
+				pos = body->firstLink - 1;
+				return *this;
+			}
+			const uint32_t link = body->getLink(--pos);
+			cell = Cell{ cell.x - DELTA_X[link], cell.y - DELTA_Y[link] };
+			return *this;
+		}
+		Iterator operator++(int) { Iterator tmp = *this; ++*this; return tmp; }
+		bool operator==(const Iterator& other) const { return pos == other.pos; }
+	};
+
+	// a body of one segment, room for minCapacity segments before growing
+	PackedBody(const Cell& head, size_t minCapacity = 64);
+	// body from head to tail, consecutive cells have to be neighbours
+	template<typename Cells>
+	explicit PackedBody(const Cells& body, size_t minCapacity = 64) : PackedBody(*std::begin(body), minCapacity) {
+		for (auto it = std::next(std::begin(body)); it != std::end(body); ++it)
+			pushTail(*it);
+	}
+
+	size_t size() const { return static_cast<size_t>(endLink - firstLink) + 1; }
+	// segments that fit before the ring grows
+	size_t capacity() const { return static_cast<size_t>(mask) + 2; }
+	size_t getMemoryBytes() const { return words.capacity() * sizeof(uint64_t); }
+	const Cell& getHead() const { return head; }
+	const Cell& getTail() const { return tail; }
+
+	// new head next to the head, in dir
+	void pushHead(Direction dir);
+	// new tail, a neighbour of the tail
+	void pushTail(const Cell& cell);
+	// drop the tail or the head, a body keeps one segment
+	void popTail();
+	void popHead();
+
+	// head to tail
+	Iterator begin() const { return Iterator(this, endLink, head); }
+	Iterator end() const { return Iterator(this, firstLink - 1, tail); }
+
+	// calls visit(cell) from head to tail, a word of links at a time. Faster than the iterator.
+	template<typename Visit>
+	void forEachCell(Visit&& visit) const {
+		Cell cell = head;
+		visit(cell);
+		uint64_t pos = endLink;
+		while (pos != firstLink) {
+			// the links of one word, from pos - 1 down to the start of the word or firstLink
+			const uint64_t word = words[((pos - 1) & mask) / LINKS_PER_WORD];
+			const uint64_t wordStart = (pos - 1) & ~(LINKS_PER_WORD - 1);
+			const uint64_t stop = pos - firstLink < pos - wordStart ? firstLink : wordStart;
+			for (; pos != stop; --pos) {
+				const uint32_t link = static_cast<uint32_t>(word >> ((pos - 1) % LINKS_PER_WORD * 2)) & 3;
+				cell.x -= DELTA_X[link];
+				cell.y -= DELTA_Y[link];
+				visit(cell);
+			}
+		}
+	}
+};
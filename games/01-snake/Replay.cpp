@@ -0,0 +1,566 @@
+#include "Replay.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// records and structs are written as they are in memory
+static_assert(std::endian::native == std::endian::little, "replays are little endian");
+
+namespace sim {
+
+namespace {
+
+// LEB128, false when it runs past end
+bool readVarint(std::span<const uint8_t> bytes, size_t end, size_t& pos, uint64_t& value) {
+	value = 0;
+	for (uint32_t shift = 0; shift < 64 && pos < end; shift += 7) {
+		const uint8_t byte = bytes[pos++];
+		value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0)
+			return true;
+	}
+	return false;
+}
+
+template<typename T>
+bool readStruct(std::span<const uint8_t> bytes, size_t end, size_t pos, T& value) {
+	if (pos > end || end - pos < sizeof(T))
+		return false;
+	std::memcpy(&value, bytes.data() + pos, sizeof(T));
+	return true;
+}
+
+// position after the payload of a record of kind that starts at pos, false when it runs past end
+bool skipPayload(std::span<const uint8_t> bytes, size_t end, RecordKind kind, size_t& pos) {
+	switch (kind) {
+	case RecordKind::END:
+	case RecordKind::TURN_LEFT:
+	case RecordKind::TURN_RIGHT:
+		return true;
+	case RecordKind::APPLE: {
+		uint64_t cell;
+		return readVarint(bytes, end, pos, cell);
+	}
+	case RecordKind::KEYFRAME: {
+		ReplayKeyframe keyframe;
+		if (!readStruct(bytes, end, pos, keyframe))
+			return false;
+		const uint64_t size = sizeof(ReplayKeyframe) + static_cast<uint64_t>(keyframe.length) * 4;
+		if (size > end - pos)
+			return false;
+		pos += static_cast<size_t>(size);
+		return true;
+	}
+	}
+	return false;
+}
+
+// At least the head, every cell inside the grid and none twice, the player builds a Snake from the cells as they are.
+// The payload is complete, indices is scratch.
+bool isValidKeyframe(std::span<const uint8_t> bytes, size_t payload, int32_t gridSize, std::vector<uint64_t>& indices) {
+	ReplayKeyframe keyframe;
+	std::memcpy(&keyframe, bytes.data() + payload, sizeof(keyframe));
+	if (keyframe.length == 0 || (keyframe.hasApple != 0 && (keyframe.appleX >= gridSize || keyframe.appleY >= gridSize)))
+		return false;
+	indices.clear();
+	const uint8_t* cells = bytes.data() + payload + sizeof(ReplayKeyframe);
+	for (size_t ix = 0; ix < keyframe.length; ++ix) {
+		uint16_t xy[2];
+		std::memcpy(xy, cells + ix * 4, 4);
+		if (xy[0] >= gridSize || xy[1] >= gridSize)
+			return false;
+		indices.push_back(static_cast<uint64_t>(xy[1]) * gridSize + xy[0]);
+	}
+	std::sort(indices.begin(), indices.end());
+	return std::adjacent_find(indices.begin(), indices.end()) == indices.end();
+}
+
+}
+
+//------------- ReplayWriter
+
+ReplayWriter::~ReplayWriter() {
+	// cut short, readable without the footer
+	if (file)
+		std::fclose(file);
+}
+
+void ReplayWriter::write(const void* data, size_t size) {
+	std::fwrite(data, 1, size, file);
+	offset += size;
+}
+
+void ReplayWriter::writeVarint(uint64_t value) {
+	uint8_t bytes[10];
+	size_t count = 0;
+	do {
+		uint8_t byte = value & 0x7F;
+		value >>= 7;
+		if (value != 0)
+			byte |= 0x80;
+		bytes[count++] = byte;
+	} while (value != 0);
+	write(bytes, count);
+}
+
+void ReplayWriter::writeRecord(uint64_t tick, RecordKind kind) {
+	writeVarint(((tick - lastTick) << 3) | static_cast<uint8_t>(kind));
+	lastTick = tick;
+}
+
+void ReplayWriter::writeKeyframe(const State& state) {
+	const uint64_t recordOffset = offset;
+	writeRecord(state.ticks, RecordKind::KEYFRAME);
+
+	ReplayKeyframe keyframe;
+	keyframe.tick = state.ticks;
+	keyframe.previousOffset = lastKeyframeOffset;
+	keyframe.rngState = state.rng.getState();
+	keyframe.rngIncrement = state.rng.getIncrement();
+	keyframe.score = state.score;
+	keyframe.length = static_cast<uint32_t>(state.snake.getCells().size());
+	keyframe.appleX = static_cast<uint16_t>(state.apple.x);
+	keyframe.appleY = static_cast<uint16_t>(state.apple.y);
+	keyframe.hasApple = state.hasApple ? 1 : 0;
+	keyframe.direction = static_cast<uint8_t>(state.snake.getDirection());
+	write(&keyframe, sizeof(keyframe));
+
+	// batched on the stack, one fwrite per 64 cells
+	uint16_t cells[128];
+	size_t count = 0;
+	for (const Cell& cell : state.snake.getCells()) {
+		cells[count++] = static_cast<uint16_t>(cell.x);
+		cells[count++] = static_cast<uint16_t>(cell.y);
+		if (count == std::size(cells)) {
+			write(cells, sizeof(cells));
+			count = 0;
+		}
+	}
+	write(cells, count * sizeof(uint16_t));
+
+	lastKeyframeOffset = recordOffset;
+	++keyframeCount;
+}
+
+bool ReplayWriter::begin(const std::string& filePath, const State& state, int32_t period, uint16_t interval) {
+	if (file)
+		std::fclose(file);
+	path = filePath;
+	file = std::fopen(path.c_str(), "wb");
+	if (!file) {
+		std::cerr << "Could not open " << path << " to record the game\n";
+		return false;
+	}
+	offset = 0;
+	lastTick = state.ticks;
+	lastKeyframeOffset = 0;
+	keyframeCount = 0;
+	keyframeInterval = std::max<uint16_t>(1, interval);
+	gridSize = state.snake.getGrid().getGridSize();
+
+	ReplayHeader header;
+	header.keyframeInterval = keyframeInterval;
+	header.gridSize = gridSize;
+	header.period = period;
+	header.rngState = state.rng.getState();
+	header.rngIncrement = state.rng.getIncrement();
+	write(&header, sizeof(header));
+	// the first apple, also allocates the stdio buffer before the game starts
+	recordApple(state);
+	return true;
+}
+
+void ReplayWriter::recordStep(const State& state, Action action) {
+	if (!file)
+		return;
+	if (state.ticks > 0 && state.ticks % keyframeInterval == 0)
+		writeKeyframe(state);
+	if (action == Action::TURN_LEFT)
+		writeRecord(state.ticks, RecordKind::TURN_LEFT);
+	else if (action == Action::TURN_RIGHT)
+		writeRecord(state.ticks, RecordKind::TURN_RIGHT);
+}
+
+void ReplayWriter::recordApple(const State& state) {
+	if (!file)
+		return;
+	writeRecord(state.ticks, RecordKind::APPLE);
+	writeVarint(state.hasApple ? static_cast<uint64_t>(state.apple.y) * gridSize + state.apple.x + 1 : 0);
+}
+
+void ReplayWriter::end(const State& state) {
+	if (!file)
+		return;
+	writeRecord(state.ticks, RecordKind::END);
+	ReplayFooter footer;
+	footer.lastKeyframeOffset = lastKeyframeOffset;
+	footer.endTick = state.ticks;
+	footer.keyframeCount = keyframeCount;
+	write(&footer, sizeof(footer));
+	std::fclose(file);
+	file = nullptr;
+}
+
+void ReplayWriter::discard() {
+	if (!file)
+		return;
+	std::fclose(file);
+	file = nullptr;
+	std::remove(path.c_str());
+}
+
+//------------- MappedFile
+
+MappedFile::~MappedFile() {
+	close();
+}
+
+bool MappedFile::open(const std::string& path) {
+	close();
+#ifdef _WIN32
+	HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (handle == INVALID_HANDLE_VALUE) {
+		std::cerr << "Could not open " << path << "\n";
+		return false;
+	}
+	LARGE_INTEGER fileSize{};
+	GetFileSizeEx(handle, &fileSize);
+	fileHandle = handle;
+	size = static_cast<size_t>(fileSize.QuadPart);
+	if (size == 0)
+		return true;
+	mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping)
+		data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+	const int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		std::cerr << "Could not open " << path << "\n";
+		return false;
+	}
+	struct stat info{};
+	fstat(fd, &info);
+	size = static_cast<size_t>(info.st_size);
+	if (size == 0) {
+		::close(fd);
+		return true;
+	}
+	void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	// the mapping stays valid without the descriptor
+	::close(fd);
+	if (mapped != MAP_FAILED) {
+		data = static_cast<const uint8_t*>(mapped);
+		// read front to back by players and scans
+		madvise(mapped, size, MADV_SEQUENTIAL);
+	}
+#endif
+	if (!data) {
+		std::cerr << "Could not map " << path << "\n";
+		close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::close() {
+#ifdef _WIN32
+	if (data)
+		UnmapViewOfFile(data);
+	if (mapping)
+		CloseHandle(mapping);
+	if (fileHandle)
+		CloseHandle(fileHandle);
+	mapping = nullptr;
+	fileHandle = nullptr;
+#else
+	if (data)
+		munmap(const_cast<uint8_t*>(data), size);
+#endif
+	data = nullptr;
+	size = 0;
+}
+
+//------------- Replay
+
+bool Replay::open(std::span<const uint8_t> replayBytes) {
+	bytes = replayBytes;
+	keyframes.clear();
+	hasFooter = false;
+	endTick = 0;
+	if (!readStruct(bytes, bytes.size(), 0, header) || header.magic != REPLAY_MAGIC) {
+		std::cerr << "Not a replay\n";
+		return false;
+	}
+	if (header.version != REPLAY_VERSION || header.gridSize <= 0 || header.gridSize > UINT16_MAX || header.keyframeInterval == 0) {
+		std::cerr << "Unsupported replay, version " << header.version << "\n";
+		return false;
+	}
+
+	ReplayFooter footer;
+	const size_t footerOffset = bytes.size() - sizeof(ReplayFooter);
+	if (bytes.size() >= sizeof(ReplayHeader) + sizeof(ReplayFooter) && readStruct(bytes, bytes.size(), footerOffset, footer)
+		&& footer.magic == REPLAY_FOOTER_MAGIC) {
+		hasFooter = true;
+		recordsEnd = footerOffset;
+		endTick = footer.endTick;
+		// a footer counting more keyframes than fit before it is broken, the count must not size the index
+		if (footer.keyframeCount > (recordsEnd - sizeof(ReplayHeader)) / (1 + sizeof(ReplayKeyframe)))
+			return scanRecords();
+		// walk the keyframe chain backwards, only the keyframe records are touched
+		keyframes.resize(footer.keyframeCount);
+		std::vector<uint64_t> indices;
+		uint64_t offset = footer.lastKeyframeOffset;
+		for (size_t ix = keyframes.size(); ix-- > 0;) {
+			size_t pos = static_cast<size_t>(offset);
+			uint64_t recordHeader;
+			ReplayKeyframe keyframe;
+			if (offset < sizeof(ReplayHeader) || offset >= recordsEnd || !readVarint(bytes, recordsEnd, pos, recordHeader)
+				|| static_cast<RecordKind>(recordHeader & 7) != RecordKind::KEYFRAME || !readStruct(bytes, recordsEnd, pos, keyframe)) {
+				// broken chain, the records are the truth
+				return scanRecords();
+			}
+			const size_t payload = pos;
+			if (!skipPayload(bytes, recordsEnd, RecordKind::KEYFRAME, pos))
+				return scanRecords();
+			if (!isValidKeyframe(bytes, payload, header.gridSize, indices)) {
+				std::cerr << "Broken replay, keyframe at tick " << keyframe.tick << "\n";
+				return false;
+			}
+			keyframes[ix] = { keyframe.tick, offset };
+			offset = keyframe.previousOffset;
+		}
+		return true;
+	}
+
+	recordsEnd = bytes.size();
+	return scanRecords();
+}
+
+bool Replay::scanRecords() {
+	keyframes.clear();
+	std::vector<uint64_t> indices;
+	uint64_t tick = 0;
+	size_t pos = sizeof(ReplayHeader);
+	while (pos < recordsEnd) {
+		const size_t recordOffset = pos;
+		uint64_t recordHeader;
+		if (!readVarint(bytes, recordsEnd, pos, recordHeader))
+			break;
+		const RecordKind kind = static_cast<RecordKind>(recordHeader & 7);
+		const size_t payload = pos;
+		if (!skipPayload(bytes, recordsEnd, kind, pos))
+			break;
+		tick += recordHeader >> 3;
+		if (kind == RecordKind::KEYFRAME) {
+			if (!isValidKeyframe(bytes, payload, header.gridSize, indices)) {
+				std::cerr << "Broken replay, keyframe at tick " << tick << "\n";
+				return false;
+			}
+			keyframes.push_back({ tick, recordOffset });
+		} else if (kind == RecordKind::END) {
+			endTick = tick;
+			return true;
+		}
+	}
+	// cut short, the game ends with the last complete record
+	endTick = tick;
+	return true;
+}
+
+//------------- ReplayPlayer
+
+ReplayPlayer::ReplayPlayer(const Replay& replay)
+	: replay(replay), state{ replay.getHeader().gridSize, Rng::fromState(replay.getHeader().rngState, replay.getHeader().rngIncrement) } {
+	// as Snake, a huge grid grows the body on demand
+	constexpr size_t MAX_RESERVED_CELLS = 1 << 16;
+	body.reserve(std::min(static_cast<size_t>(replay.getHeader().gridSize) * replay.getHeader().gridSize, MAX_RESERVED_CELLS));
+	rewind();
+}
+
+bool ReplayPlayer::readRecordHeader(uint64_t& tick, RecordKind& kind, size_t& next) const {
+	next = cursor;
+	uint64_t recordHeader;
+	if (!readVarint(replay.getBytes(), replay.getRecordsEnd(), next, recordHeader))
+		return false;
+	tick = recordTick + (recordHeader >> 3);
+	kind = static_cast<RecordKind>(recordHeader & 7);
+	return true;
+}
+
+void ReplayPlayer::readRecords() {
+	const std::span<const uint8_t> bytes = replay.getBytes();
+	const size_t end = replay.getRecordsEnd();
+	while (!isEnded) {
+		uint64_t tick;
+		RecordKind kind;
+		size_t pos;
+		if (!readRecordHeader(tick, kind, pos)) {
+			// no more records, a recording that was cut short ends here
+			isEnded = state.ticks >= replay.getEndTick();
+			return;
+		}
+		if (tick > state.ticks)
+			return;
+
+		const size_t payload = pos;
+		if (!skipPayload(bytes, end, kind, pos)) {
+			cursor = end;
+			continue;
+		}
+		cursor = pos;
+		recordTick = tick;
+		switch (kind) {
+		case RecordKind::END:
+			isEnded = true;
+			break;
+		case RecordKind::TURN_LEFT:
+			pendingAction = Action::TURN_LEFT;
+			break;
+		case RecordKind::TURN_RIGHT:
+			pendingAction = Action::TURN_RIGHT;
+			break;
+		case RecordKind::APPLE: {
+			size_t applePos = payload;
+			uint64_t cell;
+			const int32_t gridSize = replay.getHeader().gridSize;
+			if (!readVarint(bytes, end, applePos, cell) || cell > static_cast<uint64_t>(gridSize) * gridSize) {
+				// an apple off the grid, playback cannot go on
+				++keyframeMismatches;
+				cursor = end;
+				isEnded = true;
+				break;
+			}
+			state.hasApple = cell != 0;
+			if (state.hasApple)
+				state.apple = Cell{ static_cast<int32_t>((cell - 1) % gridSize), static_cast<int32_t>((cell - 1) / gridSize) };
+			break;
+		}
+		case RecordKind::KEYFRAME:
+			if (!matchesKeyframe(payload))
+				++keyframeMismatches;
+			break;
+		}
+	}
+}
+
+bool ReplayPlayer::matchesKeyframe(size_t payload) const {
+	const std::span<const uint8_t> bytes = replay.getBytes();
+	ReplayKeyframe keyframe;
+	readStruct(bytes, replay.getRecordsEnd(), payload, keyframe);
+	const Snake& snake = state.snake;
+	if (keyframe.tick != state.ticks || keyframe.score != state.score || keyframe.length != snake.getCells().size()
+		|| keyframe.direction != static_cast<uint8_t>(snake.getDirection()) || (keyframe.hasApple != 0) != state.hasApple
+		|| keyframe.rngState != state.rng.getState() || keyframe.rngIncrement != state.rng.getIncrement())
+		return false;
+	if (state.hasApple && (keyframe.appleX != state.apple.x || keyframe.appleY != state.apple.y))
+		return false;
+	const uint8_t* cells = bytes.data() + payload + sizeof(ReplayKeyframe);
+	for (size_t ix = 0; ix < keyframe.length; ++ix) {
+		uint16_t xy[2];
+		std::memcpy(xy, cells + ix * 4, 4);
+		if (xy[0] != snake.getCells()[ix].x || xy[1] != snake.getCells()[ix].y)
+			return false;
+	}
+	return true;
+}
+
+void ReplayPlayer::restoreKeyframe(size_t offset) {
+	const std::span<const uint8_t> bytes = replay.getBytes();
+	const size_t end = replay.getRecordsEnd();
+	size_t pos = offset;
+	uint64_t recordHeader;
+	ReplayKeyframe keyframe;
+	readVarint(bytes, end, pos, recordHeader);
+	readStruct(bytes, end, pos, keyframe);
+	const size_t payload = pos;
+	skipPayload(bytes, end, RecordKind::KEYFRAME, pos);
+
+	body.clear();
+	const uint8_t* cells = bytes.data() + payload + sizeof(ReplayKeyframe);
+	for (size_t ix = 0; ix < keyframe.length; ++ix) {
+		uint16_t xy[2];
+		std::memcpy(xy, cells + ix * 4, 4);
+		body.push_back(Cell{ xy[0], xy[1] });
+	}
+	const int32_t gridSize = replay.getHeader().gridSize;
+	state.snake = Snake{ body, static_cast<Direction>(keyframe.direction & 3), gridSize };
+	state.apple = Cell{ keyframe.appleX, keyframe.appleY };
+	state.hasApple = keyframe.hasApple != 0;
+	state.score = keyframe.score;
+	state.ticks = keyframe.tick;
+	state.rng = Rng::fromState(keyframe.rngState, keyframe.rngIncrement);
+
+	cursor = pos;
+	recordTick = keyframe.tick;
+	pendingAction = Action::NONE;
+	lastOutcome = Outcome::MOVED;
+	isEnded = false;
+	// the turn at the keyframe's tick follows it
+	readRecords();
+}
+
+void ReplayPlayer::rewind() {
+	const ReplayHeader& header = replay.getHeader();
+	const Rng rng = Rng::fromState(header.rngState, header.rngIncrement);
+	// the apple drawn here is replaced by the first apple record
+	state = State{ header.gridSize, rng };
+	state.rng = rng;
+	cursor = sizeof(ReplayHeader);
+	recordTick = 0;
+	pendingAction = Action::NONE;
+	lastOutcome = Outcome::MOVED;
+	isEnded = false;
+	readRecords();
+}
+
+Outcome ReplayPlayer::tick() {
+	if (isEnded)
+		return lastOutcome;
+	const Action action = pendingAction;
+	pendingAction = Action::NONE;
+	// sim::step may place a different apple than the recording, the apple record of the new tick replaces it
+	lastOutcome = step(state, action);
+	readRecords();
+	if (isGameOver(lastOutcome))
+		isEnded = true;
+	return lastOutcome;
+}
+
+uint64_t ReplayPlayer::fastForward() {
+	const uint64_t start = state.ticks;
+	while (!isEnded)
+		tick();
+	return state.ticks - start;
+}
+
+void ReplayPlayer::seek(uint64_t target) {
+	const std::vector<ReplayKeyframeEntry>& keyframes = replay.getKeyframes();
+	const auto after = std::upper_bound(keyframes.begin(), keyframes.end(), target,
+		[](uint64_t tick, const ReplayKeyframeEntry& entry) { return tick < entry.tick; });
+	const bool isBehind = target < state.ticks;
+	if (after != keyframes.begin()) {
+		const ReplayKeyframeEntry& keyframe = *(after - 1);
+		// restore unless simulating from where we are is shorter
+		if (isBehind || keyframe.tick > state.ticks)
+			restoreKeyframe(static_cast<size_t>(keyframe.offset));
+	}
+	else if (isBehind)
+		rewind();
+	while (state.ticks < target && !isEnded)
+		tick();
+}
+
+}
@@ -0,0 +1,222 @@
+#pragma once
+
+#include "Cell.h"
+#include "Simulation.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include <string>
+#include <vector>
+
+// Recording and playback of games as compact binary input logs.
+//
+// File layout, little endian, no alignment requirements so that a mapped file is read in place:
+//   ReplayHeader
+//   records: a varint (tick delta << 3 | RecordKind) followed by the payload of the kind
+//   ReplayFooter, missing when the recording was cut short (the records are still readable)
+// Tick deltas are counted from the previous record, a turn costs one or two bytes.
+// Apples are recorded where they appear instead of being drawn again on playback, so replays
+// do not depend on the apple sampling of the version that plays them.
+// Keyframes hold the whole state every keyframeInterval ticks and link back to the previous one,
+// seeking restores the last keyframe before the target and simulates the rest.
+namespace sim {
+
+constexpr uint32_t REPLAY_MAGIC = 0x52534447; // "GDSR"
+constexpr uint32_t REPLAY_FOOTER_MAGIC = 0x49534447; // "GDSI"
+constexpr uint16_t REPLAY_VERSION = 1;
+
+enum class RecordKind : uint8_t {
+	// game over or the player left, no payload
+	END = 0,
+	// action of the step at this tick, no payload
+	TURN_LEFT = 1,
+	TURN_RIGHT = 2,
+	// varint cell index (y * gridSize + x) + 1, 0 when the grid is full
+	APPLE = 3,
+	// ReplayKeyframe followed by length (uint16 x, uint16 y) cells from head to tail
+	KEYFRAME = 4
+};
+
+struct ReplayHeader {
+	uint32_t magic = REPLAY_MAGIC;
+	uint16_t version = REPLAY_VERSION;
+	uint16_t keyframeInterval{};
+	int32_t gridSize{};
+	// ms per tick when recorded, the speed of real time playback
+	int32_t period{};
+	// rng at tick 0, after the first apple was placed
+	uint64_t rngState{};
+	uint64_t rngIncrement{};
+};
+static_assert(sizeof(ReplayHeader) == 32);
+
+struct ReplayKeyframe {
+	uint64_t tick{};
+	// file offset of the previous keyframe's record, 0 for none
+	uint64_t previousOffset{};
+	uint64_t rngState{};
+	uint64_t rngIncrement{};
+	uint32_t score{};
+	uint32_t length{};
+	uint16_t appleX{};
+	uint16_t appleY{};
+	uint8_t hasApple{};
+	uint8_t direction{};
+	uint16_t reserved{};
+};
+static_assert(sizeof(ReplayKeyframe) == 48);
+
+struct ReplayFooter {
+	// file offset of the last keyframe's record, 0 for none
+	uint64_t lastKeyframeOffset{};
+	uint64_t endTick{};
+	uint32_t keyframeCount{};
+	uint32_t magic = REPLAY_FOOTER_MAGIC;
+};
+static_assert(sizeof(ReplayFooter) == 24);
+
+// Streams a game into a file while it is played. The caller reports every tick, the writer decides
+// what is recorded. Writes go through the stdio buffer, recording does not allocate after begin().
+class ReplayWriter {
+private:
+	std::FILE* file = nullptr;
+	std::string path;
+	uint64_t offset{};
+	uint64_t lastTick{};
+	uint64_t lastKeyframeOffset{};
+	uint32_t keyframeCount{};
+	uint16_t keyframeInterval{};
+	int32_t gridSize{};
+
+private:
+	void write(const void* data, size_t size);
+	void writeVarint(uint64_t value);
+	void writeRecord(uint64_t tick, RecordKind kind);
+	void writeKeyframe(const State& state);
+
+public:
+	ReplayWriter() = default;
+	ReplayWriter(const ReplayWriter& other) = delete;
+	ReplayWriter& operator=(const ReplayWriter& other) = delete;
+	~ReplayWriter();
+
+	// starts recording the game that begins with state, a previous recording that was not ended is left cut short. False if the file can't be opened.
+	bool begin(const std::string& path, const State& state, int32_t period, uint16_t keyframeInterval = 256);
+	bool isRecording() const { return file != nullptr; }
+	// before sim::step(state, action)
+	void recordStep(const State& state, Action action);
+	// after a step that ate the apple, the new apple
+	void recordApple(const State& state);
+	// writes the end record and the footer and closes the file, does nothing when not recording
+	void end(const State& state);
+	// closes and deletes the file, for games that were not played
+	void discard();
+};
+
+// Read only view of a file in memory, mapped by the OS: pages are loaded when they are touched,
+// scanning a large archive does not read it all.
+class MappedFile {
+private:
+	const uint8_t* data = nullptr;
+	size_t size{};
+#ifdef _WIN32
+	void* fileHandle = nullptr;
+	void* mapping = nullptr;
+#endif
+
+public:
+	MappedFile() = default;
+	MappedFile(const MappedFile& other) = delete;
+	MappedFile& operator=(const MappedFile& other) = delete;
+	~MappedFile();
+
+	bool open(const std::string& path);
+	void close();
+	std::span<const uint8_t> getBytes() const { return { data, size }; }
+};
+
+struct ReplayKeyframeEntry {
+	uint64_t tick{};
+	uint64_t offset{};
+};
+
+// Header and keyframe index of a replay. Does not copy the bytes, they have to outlive it.
+class Replay {
+private:
+	std::span<const uint8_t> bytes;
+	ReplayHeader header;
+	// ascending ticks
+	std::vector<ReplayKeyframeEntry> keyframes;
+	// end of the records, the footer starts here when there is one
+	size_t recordsEnd{};
+	uint64_t endTick{};
+	bool hasFooter = false;
+
+private:
+	// false when a keyframe is not a valid state
+	bool scanRecords();
+
+public:
+	// false with a message on std::cerr when the bytes are not a replay or a keyframe is not a valid state
+	bool open(std::span<const uint8_t> bytes);
+
+	const ReplayHeader& getHeader() const { return header; }
+	std::span<const uint8_t> getBytes() const { return bytes; }
+	size_t getRecordsEnd() const { return recordsEnd; }
+	const std::vector<ReplayKeyframeEntry>& getKeyframes() const { return keyframes; }
+	// tick of the end record, the length of the game
+	uint64_t getEndTick() const { return endTick; }
+	// false for a recording that was cut short
+	bool isComplete() const { return hasFooter; }
+};
+
+// Plays a replay with the rules of sim::step: tick() for real time viewing, fastForward() and seek() headless.
+class ReplayPlayer {
+private:
+	const Replay& replay;
+	State state;
+	size_t cursor{};
+	// tick of the record before the cursor
+	uint64_t recordTick{};
+	// turn of the step at the current tick
+	Action pendingAction = Action::NONE;
+	Outcome lastOutcome = Outcome::MOVED;
+	bool isEnded = false;
+	// keyframes passed during playback that did not match the simulated state, and apple records off the grid that
+	// ended it
+	uint64_t keyframeMismatches{};
+	std::vector<Cell> body;
+
+private:
+	// reads the records of the current tick: apples and keyframes, then the turn of its step
+	void readRecords();
+	bool readRecordHeader(uint64_t& tick, RecordKind& kind, size_t& next) const;
+	void restoreKeyframe(size_t offset);
+	bool matchesKeyframe(size_t payload) const;
+
+public:
+	// positioned at tick 0
+	ReplayPlayer(const Replay& replay);
+
+	const State& getState() const { return state; }
+	const Replay& getReplay() const { return replay; }
+	uint64_t getTick() const { return state.ticks; }
+	// action of the next step
+	Action peekAction() const { return pendingAction; }
+	Outcome getLastOutcome() const { return lastOutcome; }
+	bool isFinished() const { return isEnded; }
+	uint64_t getKeyframeMismatches() const { return keyframeMismatches; }
+
+	// one step, does nothing once finished
+	Outcome tick();
+	// steps until the end, returns the number of steps
+	uint64_t fastForward();
+	// state at the given tick (or the end), from the closest keyframe before it
+	void seek(uint64_t tick);
+	// back to tick 0
+	void rewind();
+};
+
+}
@@ -0,0 +1,64 @@
+#include "Replay.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Headless replay tool: SnakeReplay [--seek tick] files...
+// Fast-forwards every replay at full speed, checks the simulated states against its keyframes
+// and prints a summary line per file. With --seek it also prints the state at the tick.
+// Exits with 1 if a file could not be read or did not match its keyframes.
+int main(int argc, char* args[]) {
+	using Clock = std::chrono::steady_clock;
+	std::vector<std::string> paths;
+	bool isSeeking = false;
+	uint64_t seekTick{};
+	for (int ix = 1; ix < argc; ++ix) {
+		const std::string arg = args[ix];
+		if (arg == "--seek" && ix + 1 < argc) {
+			isSeeking = true;
+			seekTick = std::stoull(args[++ix]);
+		}
+		else
+			paths.push_back(arg);
+	}
+	if (paths.empty()) {
+		std::printf("usage: SnakeReplay [--seek tick] files...\n");
+		return 1;
+	}
+
+	int failures = 0;
+	for (const std::string& path : paths) {
+		sim::MappedFile file;
+		sim::Replay replay;
+		if (!file.open(path) || !replay.open(file.getBytes())) {
+			std::printf("%s: unreadable\n", path.c_str());
+			++failures;
+			continue;
+		}
+
+		sim::ReplayPlayer player{ replay };
+		const Clock::time_point start = Clock::now();
+		const uint64_t ticks = player.fastForward();
+		const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+		const sim::ReplayHeader& header = replay.getHeader();
+		std::printf("%s: grid %d, period %d ms, %llu ticks, score %u, %zu keyframes%s, %.1f M ticks/s, %llu keyframe mismatches\n",
+			path.c_str(), header.gridSize, header.period, static_cast<unsigned long long>(ticks), player.getState().score,
+			replay.getKeyframes().size(), replay.isComplete() ? "" : " (cut short)", seconds > 0 ? ticks / seconds * 1e-6 : 0.0,
+			static_cast<unsigned long long>(player.getKeyframeMismatches()));
+		if (player.getKeyframeMismatches() > 0)
+			++failures;
+
+		if (isSeeking) {
+			const Clock::time_point seekStart = Clock::now();
+			player.seek(seekTick);
+			const double seekUs = std::chrono::duration<double, std::micro>(Clock::now() - seekStart).count();
+			const sim::State& state = player.getState();
+			std::printf("  tick %llu: head %d,%d, length %zu, score %u, apple %d,%d (seek %.1f us)\n",
+				static_cast<unsigned long long>(state.ticks), state.snake.getHead().x, state.snake.getHead().y,
+				state.snake.getCells().size(), state.score, state.apple.x, state.apple.y, seekUs);
+		}
+	}
+	return failures == 0 ? 0 : 1;
+}
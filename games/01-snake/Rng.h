@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+// PCG32 (pcg-random.org): 64 bit state, 32 bit output. Unlike std::mt19937 with the standard distributions,
+// a seed gives the same sequence on every platform and standard library, so a seed reproduces a game.
+// Also a UniformRandomBitGenerator, for the std algorithms.
+class Rng {
+private:
+	static constexpr uint64_t MULTIPLIER = 6364136223846793005ULL;
+	uint64_t state{};
+	uint64_t increment{};
+
+public:
+	using result_type = uint32_t;
+
+	explicit Rng(uint64_t seed = 0x853c49e6748fea9bULL, uint64_t stream = 0xda3e39cb94b95bdbULL) {
+		this->seed(seed, stream);
+	}
+
+	void seed(uint64_t seed, uint64_t stream = 0xda3e39cb94b95bdbULL) {
+		state = 0;
+		increment = (stream << 1) | 1;
+		next();
+		state += seed;
+		next();
+	}
+
+	// raw state, for snapshots that have to continue the exact sequence
+	uint64_t getState() const { return state; }
+	uint64_t getIncrement() const { return increment; }
+	static Rng fromState(uint64_t state, uint64_t increment) {
+		Rng rng;
+		rng.state = state;
+		rng.increment = increment;
+		return rng;
+	}
+
+	uint32_t next() {
+		const uint64_t old = state;
+		state = old * MULTIPLIER + increment;
+		const uint32_t xorShifted = static_cast<uint32_t>(((old >> 18) ^ old) >> 27);
+		const uint32_t rotation = static_cast<uint32_t>(old >> 59);
+		return (xorShifted >> rotation) | (xorShifted << ((32 - rotation) & 31));
+	}
+
+	// uniform in [0, bound), bound > 0. Multiply and shift with rejection of the biased low range (Lemire).
+	uint32_t nextBelow(uint32_t bound) {
+		uint64_t product = static_cast<uint64_t>(next()) * bound;
+		uint32_t low = static_cast<uint32_t>(product);
+		if (low < bound) {
+			const uint32_t threshold = (0u - bound) % bound;
+			while (low < threshold) {
+				product = static_cast<uint64_t>(next()) * bound;
+				low = static_cast<uint32_t>(product);
+			}
+		}
+		return static_cast<uint32_t>(product >> 32);
+	}
+
+	static constexpr result_type min() { return 0; }
+	static constexpr result_type max() { return std::numeric_limits<uint32_t>::max(); }
+	result_type operator()() { return next(); }
+};
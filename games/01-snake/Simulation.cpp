@@ -0,0 +1,52 @@
+#include "Simulation.h"
+
+namespace sim {
+
+//------------- State
+
+State::State(int32_t gridSize, Rng rng)
+	: snake{ Cell{ gridSize / 2, gridSize / 2 }, 2, Direction::LEFT, gridSize }, rng{ rng } {
+	placeApple(*this);
+}
+
+//------------- rules
+
+bool placeApple(State& state) {
+	// O(1) and allocation free, the occupancy grid keeps track of the free cells
+	const OccupancyGrid& grid = state.snake.getGrid();
+	state.hasApple = grid.getFreeCount() > 0;
+	if (state.hasApple)
+		state.apple = grid.sampleFree(state.rng);
+	return state.hasApple;
+}
+
+Outcome step(State& state, Action action) {
+	Snake& snake = state.snake;
+	switch (action) {
+	case Action::TURN_LEFT:
+		snake.turnLeft();
+		break;
+	case Action::TURN_RIGHT:
+		snake.turnRight();
+		break;
+	case Action::NONE:
+		break;
+	}
+	++state.ticks;
+
+	const Cell nextCell = snake.getNextCell();
+	if (snake.getGrid().isWall(nextCell))
+		return Outcome::HIT_WALL;
+	if (snake.willBiteItself(nextCell))
+		return Outcome::BIT_ITSELF;
+	if (state.hasApple && nextCell.isSameAs(state.apple)) {
+		snake.elongate();
+		placeApple(state);
+		++state.score;
+		return Outcome::ATE_APPLE;
+	}
+	snake.move();
+	return Outcome::MOVED;
+}
+
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Cell.h"
+#include "Rng.h"
+#include "Snake.h"
+
+#include <cstdint>
+
+// The rules of Snake without SDL, time or input devices: one step is one tick of the game.
+// Deterministic, the same seed and actions give the same game.
+namespace sim {
+
+enum class Action : uint8_t {
+	NONE, TURN_LEFT, TURN_RIGHT
+};
+
+// direction after the action's turn, as Snake::turnLeft() and turnRight()
+constexpr Direction turned(Direction dir, Action action) {
+	const int turn = action == Action::TURN_LEFT ? 1 : action == Action::TURN_RIGHT ? 3 : 0;
+	return static_cast<Direction>((static_cast<int>(dir) + turn) & 3);
+}
+static_assert(turned(Direction::UP, Action::TURN_LEFT) == Direction::RIGHT && turned(Direction::UP, Action::TURN_RIGHT) == Direction::LEFT);
+
+enum class Outcome : uint8_t {
+	MOVED, ATE_APPLE, HIT_WALL, BIT_ITSELF
+};
+
+inline bool isGameOver(Outcome outcome) {
+	return outcome == Outcome::HIT_WALL || outcome == Outcome::BIT_ITSELF;
+}
+
+struct State {
+	Snake snake;
+	Cell apple{};
+	// false once the snake fills the grid, there is no free cell left for an apple
+	bool hasApple = false;
+	uint32_t score{};
+	uint64_t ticks{};
+	Rng rng;
+
+	// snake of length 2 in the middle of the grid heading left, apple placed with rng
+	State(int32_t gridSize, Rng rng);
+};
+
+// apple on a uniformly random free cell, false when the grid is full
+bool placeApple(State& state);
+
+// turns, then moves, eats or collides. On a game over the snake stays where it was.
+Outcome step(State& state, Action action);
+
+}
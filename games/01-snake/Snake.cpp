@@ -1,42 +1,81 @@
 #include "Snake.h"
 
-#include <gds.h>
+#include <algorithm>
 
-Snake::Snake(Cell head, uint32_t length, Direction dir)
-	: dir{ dir } {
+namespace {
+
+// Room for a snake that fills the grid, so that elongating never allocates. Huge grids start with a cap
+// and the ring grows when the snake gets longer, memory follows the snake rather than the area.
+size_t reservedCells(int32_t gridSize) {
+	constexpr size_t MAX_RESERVED_CELLS = 1 << 16;
+	return std::min(static_cast<size_t>(gridSize) * gridSize, MAX_RESERVED_CELLS);
+}
+
+}
+
+Snake::Snake(Cell head, uint32_t length, Direction dir, int32_t gridSize)
+	: cells{ reservedCells(gridSize) }, dir{ dir }, grid{ gridSize } {
 	Cell cell = head;
 	for (int i = 0; i < length; ++i) {
-		cells.push_back(cell);
+		cells.pushBack(cell);
+		grid.set(cell, OccupancyGrid::Content::SNAKE);
 		cell = cell.addCell(Cell::deltaCell(dir));
 	}
 }
 
+Snake::Snake(std::span<const Cell> body, Direction dir, int32_t gridSize)
+	: cells{ reservedCells(gridSize) }, dir{ dir }, grid{ gridSize } {
+	for (const Cell& cell : body)
+		pushTail(cell);
+}
+
 // signs are opposite because the rendering surface is upside-down
-void Snake::turnRight() { dir = static_cast<Direction>(gds::positiveModulus(static_cast<int>(dir) - 1, 4)); }
-void Snake::turnLeft() { dir = static_cast<Direction>(gds::positiveModulus(static_cast<int>(dir) + 1, 4)); }
+void Snake::turnRight() { dir = static_cast<Direction>((static_cast<int>(dir) + 3) % 4); }
+void Snake::turnLeft() { dir = static_cast<Direction>((static_cast<int>(dir) + 1) % 4); }
 
-Cell Snake::getNextCell() {
+Cell Snake::getNextCell() const {
 	return getHead().addCell(Cell::deltaCell(dir));
 }
 
 void Snake::move() {
-	for (size_t ix = cells.size() - 1; ix > 0; --ix)
-		cells[ix] = cells[ix - 1];
-	const Cell dc = Cell::deltaCell(dir);
-	cells[0] = cells[0].addCell(dc);
+	const Cell nextCell = getNextCell();
+	// free the tail first, the head may move into the cell it vacates
+	grid.set(getTail(), OccupancyGrid::Content::EMPTY);
+	cells.popBack();
+	cells.pushFront(nextCell);
+	grid.set(nextCell, OccupancyGrid::Content::SNAKE);
 }
 
 void Snake::elongate() {
-	cells.insert(cells.begin(), getNextCell());
+	const Cell nextCell = getNextCell();
+	cells.pushFront(nextCell);
+	grid.set(nextCell, OccupancyGrid::Content::SNAKE);
 }
 
-bool Snake::hasCell(const Cell& other) {
+void Snake::setDirection(Direction direction) {
+	dir = direction;
+}
+
+void Snake::clear() {
 	for (const Cell& cell : cells)
-		if (cell.isSameAs(other))
-			return true;
-	return false;
+		grid.set(cell, OccupancyGrid::Content::EMPTY);
+	cells.clear();
+}
+
+void Snake::pushTail(const Cell& cell) {
+	cells.pushBack(cell);
+	grid.set(cell, OccupancyGrid::Content::SNAKE);
+}
+
+void Snake::retractHead() {
+	grid.set(getHead(), OccupancyGrid::Content::EMPTY);
+	cells.popFront();
+}
+
+bool Snake::hasCell(const Cell& other) const {
+	return grid.isSnake(other);
 }
 
-bool Snake::willBiteItself(const Cell& nextCell) {
+bool Snake::willBiteItself(const Cell& nextCell) const {
 	return hasCell(nextCell) && !nextCell.isSameAs(getTail());
 }
\ No newline at end of file
@@ -1,33 +1,48 @@
 #pragma once
 
 #include "Cell.h"
+#include "OccupancyGrid.h"
 
-#include <vector>
+#include <RingBuffer.h>
+
+#include <span>
 
 class Snake {
 private:
-	// from head to tail
-	std::vector<Cell> cells;
+	// from head to tail. A tick pushes a new head and pops the tail, no shifting of the body.
+	gds::RingBuffer<Cell> cells;
 	Direction dir;
+	// kept in sync with cells for O(1) collision queries
+	OccupancyGrid grid;
 
 public:
-	Snake(Cell head, uint32_t length, Direction dir);
+	Snake(Cell head, uint32_t length, Direction dir, int32_t gridSize);
+	// body from head to tail, for restoring a saved snake
+	Snake(std::span<const Cell> body, Direction dir, int32_t gridSize);
 
-	inline const std::vector<Cell>& getCells() const { return cells; }
-	inline const Cell& getHead() const { return cells[0]; }
+	inline const gds::RingBuffer<Cell>& getCells() const { return cells; }
+	inline const Cell& getHead() const { return cells.front(); }
 	inline const Cell& getTail() const { return cells.back(); }
+	inline const OccupancyGrid& getGrid() const { return grid; }
+	inline Direction getDirection() const { return dir; }
 
 	// signs are opposite because the rendering surface is upside-down
 	void turnRight();
 	void turnLeft();
 
-	Cell getNextCell();
+	Cell getNextCell() const;
 
 	void move();
 
 	void elongate();
 
-	bool hasCell(const Cell& other);
+	// for restoring saved states: edits the body without the rules, nothing is allocated
+	void setDirection(Direction direction);
+	void clear();
+	void pushTail(const Cell& cell);
+	void retractHead();
+
+	bool hasCell(const Cell& other) const;
 
-	bool willBiteItself(const Cell& nextCell);
+	bool willBiteItself(const Cell& nextCell) const;
 };
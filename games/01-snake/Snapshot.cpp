@@ -0,0 +1,250 @@
+#include "Snapshot.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <vector>
+
+namespace sim {
+
+namespace {
+
+// At least the head, every cell inside the grid and none twice, a Snake is built from the cells as they are
+bool isValidBody(const uint8_t* cells, uint32_t length, int32_t gridSize) {
+	if (length == 0)
+		return false;
+	// the cell indices sorted, kept between loads so that a body no longer than before does not allocate
+	thread_local std::vector<uint64_t> indices;
+	indices.clear();
+	for (uint32_t ix = 0; ix < length; ++ix) {
+		uint16_t xy[2];
+		std::memcpy(xy, cells + ix * 4, sizeof(xy));
+		if (xy[0] >= gridSize || xy[1] >= gridSize)
+			return false;
+		indices.push_back(static_cast<uint64_t>(xy[1]) * gridSize + xy[0]);
+	}
+	std::sort(indices.begin(), indices.end());
+	return std::adjacent_find(indices.begin(), indices.end()) == indices.end();
+}
+
+}
+
+//------------- snapshots
+
+size_t getSnapshotSize(const State& state) {
+	return sizeof(SnapshotHeader) + state.snake.getCells().size() * 4;
+}
+
+size_t getMaxSnapshotSize(int32_t gridSize) {
+	return sizeof(SnapshotHeader) + static_cast<size_t>(gridSize) * gridSize * 4;
+}
+
+size_t saveSnapshot(const State& state, uint32_t timer, std::span<uint8_t> out) {
+	const size_t size = getSnapshotSize(state);
+	if (out.size() < size)
+		return 0;
+
+	SnapshotHeader header;
+	header.gridSize = state.snake.getGrid().getGridSize();
+	header.ticks = state.ticks;
+	header.rngState = state.rng.getState();
+	header.rngIncrement = state.rng.getIncrement();
+	header.score = state.score;
+	header.length = static_cast<uint32_t>(state.snake.getCells().size());
+	header.timer = timer;
+	header.appleX = static_cast<uint16_t>(state.apple.x);
+	header.appleY = static_cast<uint16_t>(state.apple.y);
+	header.hasApple = state.hasApple ? 1 : 0;
+	header.direction = static_cast<uint8_t>(state.snake.getDirection());
+	std::memcpy(out.data(), &header, sizeof(header));
+
+	uint8_t* cells = out.data() + sizeof(header);
+	for (const Cell& cell : state.snake.getCells()) {
+		const uint16_t xy[2] = { static_cast<uint16_t>(cell.x), static_cast<uint16_t>(cell.y) };
+		std::memcpy(cells, xy, sizeof(xy));
+		cells += sizeof(xy);
+	}
+	return size;
+}
+
+bool loadSnapshot(std::span<const uint8_t> bytes, State& state, uint32_t& timer) {
+	SnapshotHeader header;
+	if (bytes.size() < sizeof(header))
+		return false;
+	std::memcpy(&header, bytes.data(), sizeof(header));
+	const uint64_t cellCount = static_cast<uint64_t>(header.gridSize) * header.gridSize;
+	if (header.magic != SNAPSHOT_MAGIC || header.gridSize <= 0 || header.gridSize > UINT16_MAX || header.length > cellCount
+		|| bytes.size() - sizeof(header) < static_cast<uint64_t>(header.length) * 4)
+		return false;
+	const uint8_t* cells = bytes.data() + sizeof(header);
+	if (!isValidBody(cells, header.length, header.gridSize) || (header.hasApple != 0 && (header.appleX >= header.gridSize || header.appleY >= header.gridSize)))
+		return false;
+
+	const Rng rng = Rng::fromState(header.rngState, header.rngIncrement);
+	if (state.snake.getGrid().getGridSize() != header.gridSize)
+		state = State{ header.gridSize, rng };
+
+	Snake& snake = state.snake;
+	snake.clear();
+	for (uint32_t ix = 0; ix < header.length; ++ix) {
+		uint16_t xy[2];
+		std::memcpy(xy, cells + ix * 4, sizeof(xy));
+		snake.pushTail(Cell{ xy[0], xy[1] });
+	}
+	snake.setDirection(static_cast<Direction>(header.direction & 3));
+	state.apple = Cell{ header.appleX, header.appleY };
+	state.hasApple = header.hasApple != 0;
+	state.score = header.score;
+	state.ticks = header.ticks;
+	state.rng = rng;
+	timer = header.timer;
+	return true;
+}
+
+//------------- RewindBuffer
+
+RewindBuffer::RewindBuffer(size_t capacityBytes) {
+	size_t capacity = 64;
+	while (capacity < capacityBytes)
+		capacity *= 2;
+	bytes.resize(capacity);
+	mask = capacity - 1;
+}
+
+size_t RewindBuffer::getEntrySize(uint8_t flags) {
+	// flags, the payload and a trailing size byte for walking back from the end
+	return 2 + ((flags & TURNED) ? 1 : 0) + ((flags & TAIL_DROPPED) ? 4 : 0) + ((flags & ATE) ? 17 : 0);
+}
+
+void RewindBuffer::put(uint64_t pos, const void* data, size_t size) {
+	const uint8_t* source = static_cast<const uint8_t*>(data);
+	for (size_t ix = 0; ix < size; ++ix)
+		bytes[(pos + ix) & mask] = source[ix];
+}
+
+void RewindBuffer::get(uint64_t pos, void* data, size_t size) const {
+	uint8_t* target = static_cast<uint8_t*>(data);
+	for (size_t ix = 0; ix < size; ++ix)
+		target[ix] = bytes[(pos + ix) & mask];
+}
+
+void RewindBuffer::dropOldest() {
+	first += getEntrySize(bytes[first & mask]);
+	--entryCount;
+}
+
+void RewindBuffer::capture(const State& state) {
+	const Snake& snake = state.snake;
+	before.ticks = state.ticks;
+	before.rngState = state.rng.getState();
+	before.head = snake.getHead();
+	before.tail = snake.getTail();
+	before.apple = state.apple;
+	before.length = snake.getCells().size();
+	before.score = state.score;
+	before.hasApple = state.hasApple;
+	before.direction = snake.getDirection();
+	isCaptured = true;
+}
+
+void RewindBuffer::commit(const State& state) {
+	const Snake& snake = state.snake;
+	const bool isHeadAdded = !snake.getHead().isSameAs(before.head);
+	const size_t length = before.length + (isHeadAdded ? 1 : 0);
+	// anything but a single step, a restart or a load in between, can't be undone from here
+	if (!isCaptured || state.ticks != before.ticks + 1 || (length != snake.getCells().size() && length != snake.getCells().size() + 1)) {
+		clear();
+		return;
+	}
+	isCaptured = false;
+
+	uint8_t flags = 0;
+	flags |= isHeadAdded ? HEAD_ADDED : 0;
+	flags |= length != snake.getCells().size() ? TAIL_DROPPED : 0;
+	flags |= snake.getDirection() != before.direction ? TURNED : 0;
+	flags |= state.score != before.score || state.hasApple != before.hasApple || !state.apple.isSameAs(before.apple)
+		|| state.rng.getState() != before.rngState ? ATE : 0;
+
+	const size_t size = getEntrySize(flags);
+	while (bytes.size() - getUsedBytes() < size)
+		dropOldest();
+
+	uint64_t pos = end;
+	put(pos++, &flags, 1);
+	if (flags & TURNED) {
+		const uint8_t direction = static_cast<uint8_t>(before.direction);
+		put(pos++, &direction, 1);
+	}
+	if (flags & TAIL_DROPPED) {
+		const uint16_t xy[2] = { static_cast<uint16_t>(before.tail.x), static_cast<uint16_t>(before.tail.y) };
+		put(pos, xy, sizeof(xy));
+		pos += sizeof(xy);
+	}
+	if (flags & ATE) {
+		const uint16_t xy[2] = { static_cast<uint16_t>(before.apple.x), static_cast<uint16_t>(before.apple.y) };
+		const uint8_t hasApple = before.hasApple ? 1 : 0;
+		put(pos, xy, sizeof(xy));
+		put(pos + 4, &hasApple, 1);
+		put(pos + 5, &before.score, 4);
+		put(pos + 9, &before.rngState, 8);
+		pos += 17;
+	}
+	const uint8_t entrySize = static_cast<uint8_t>(size);
+	put(pos++, &entrySize, 1);
+	end = pos;
+	++entryCount;
+}
+
+bool RewindBuffer::stepBack(State& state) {
+	if (entryCount == 0)
+		return false;
+	const uint64_t start = end - bytes[(end - 1) & mask];
+	uint8_t flags;
+	uint64_t pos = start;
+	get(pos++, &flags, 1);
+
+	Snake& snake = state.snake;
+	// head first: after moving into the cell the tail left, that cell is the head and the tail again
+	if (flags & HEAD_ADDED)
+		snake.retractHead();
+	if (flags & TURNED) {
+		uint8_t direction;
+		get(pos++, &direction, 1);
+		snake.setDirection(static_cast<Direction>(direction & 3));
+	}
+	if (flags & TAIL_DROPPED) {
+		uint16_t xy[2];
+		get(pos, xy, sizeof(xy));
+		// the cell the tail left, the head retracted first so it is free even when the head had moved into it
+		assert(snake.getGrid().isEmpty(Cell{ xy[0], xy[1] }));
+		snake.pushTail(Cell{ xy[0], xy[1] });
+		pos += sizeof(xy);
+	}
+	if (flags & ATE) {
+		uint16_t xy[2];
+		uint8_t hasApple;
+		uint64_t rngState;
+		get(pos, xy, sizeof(xy));
+		get(pos + 4, &hasApple, 1);
+		get(pos + 5, &state.score, 4);
+		get(pos + 9, &rngState, 8);
+		state.apple = Cell{ xy[0], xy[1] };
+		state.hasApple = hasApple != 0;
+		state.rng = Rng::fromState(rngState, state.rng.getIncrement());
+	}
+	--state.ticks;
+
+	end = start;
+	--entryCount;
+	isCaptured = false;
+	return true;
+}
+
+void RewindBuffer::clear() {
+	first = 0;
+	end = 0;
+	entryCount = 0;
+	isCaptured = false;
+}
+
+}
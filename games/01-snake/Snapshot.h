@@ -0,0 +1,107 @@
+#pragma once
+
+#include "Cell.h"
+#include "Simulation.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Saving, loading and rewinding of sim::State.
+namespace sim {
+
+constexpr uint32_t SNAPSHOT_MAGIC = 0x53534447; // "GDSS"
+
+// A snapshot is this header followed by length (uint16 x, uint16 y) cells from head to tail. Offsets and sizes only,
+// no pointers, so the bytes can be copied, written to disk or mapped anywhere. Little endian, see Replay.h.
+struct SnapshotHeader {
+	uint32_t magic = SNAPSHOT_MAGIC;
+	int32_t gridSize{};
+	uint64_t ticks{};
+	uint64_t rngState{};
+	uint64_t rngIncrement{};
+	uint32_t score{};
+	uint32_t length{};
+	// ms into the current tick, for front ends that step on a clock
+	uint32_t timer{};
+	uint16_t appleX{};
+	uint16_t appleY{};
+	uint8_t hasApple{};
+	uint8_t direction{};
+	uint16_t reserved{};
+	uint32_t reserved2{};
+};
+static_assert(sizeof(SnapshotHeader) == 56);
+
+// bytes needed for a snapshot of state
+size_t getSnapshotSize(const State& state);
+// largest snapshot of a grid, the snake fills it
+size_t getMaxSnapshotSize(int32_t gridSize);
+
+// writes the snapshot into out, returns its size or 0 if out is too small
+size_t saveSnapshot(const State& state, uint32_t timer, std::span<uint8_t> out);
+// Restores state and timer, false if the bytes are not a snapshot or its body is not one: no cells, a cell outside the
+// grid or a cell twice. State is untouched then. Allocation free when the grid size is the same and the body no longer
+// than in an earlier load, otherwise state is rebuilt for the new size. The free cells come back in a different order,
+// so the apples after a load can differ from the apples after the save.
+bool loadSnapshot(std::span<const uint8_t> bytes, State& state, uint32_t& timer);
+
+// Fixed size history of recent ticks for stepping the game backwards.
+//
+// A tick is stored as a reverse delta, just what the step changed: one flags byte, the cell the tail left, the direction
+// before a turn, and the apple, score and rng before eating. Usually 6 bytes per tick, independent of the snake's length.
+// Entries sit in a byte ring, the oldest ones are dropped when it is full. Nothing is allocated after construction.
+class RewindBuffer {
+private:
+	enum Flags : uint8_t {
+		HEAD_ADDED = 1, TAIL_DROPPED = 2, TURNED = 4, ATE = 8
+	};
+
+	// state before the step, set by capture()
+	struct Before {
+		uint64_t ticks{};
+		uint64_t rngState{};
+		Cell head;
+		Cell tail;
+		Cell apple;
+		size_t length{};
+		uint32_t score{};
+		bool hasApple{};
+		Direction direction{};
+	};
+
+	std::vector<uint8_t> bytes;
+	// running byte positions, wrapped with the mask on access
+	uint64_t first{};
+	uint64_t end{};
+	uint64_t mask{};
+	size_t entryCount{};
+	Before before;
+	bool isCaptured = false;
+
+private:
+	static size_t getEntrySize(uint8_t flags);
+	void put(uint64_t pos, const void* data, size_t size);
+	void get(uint64_t pos, void* data, size_t size) const;
+	void dropOldest();
+
+public:
+	// capacity is rounded up to a power of two
+	RewindBuffer(size_t capacityBytes = 64 * 1024);
+
+	// before sim::step(state, ...)
+	void capture(const State& state);
+	// after the step, stores how to undo it
+	void commit(const State& state);
+	// undoes the last committed tick, false when there is none
+	bool stepBack(State& state);
+	// forgets the history, after a restart or a load
+	void clear();
+
+	size_t getEntryCount() const { return entryCount; }
+	size_t getUsedBytes() const { return static_cast<size_t>(end - first); }
+	size_t getCapacity() const { return bytes.size(); }
+};
+
+}
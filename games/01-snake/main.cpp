@@ -1,58 +1,68 @@
-#include "GameStates.h"
-#include "Snake.h"
+#include "Game.h"
 
+#include <AllocationTracker.h>
+#include <FixedTimestep.h>
 #include <gds.h>
 
 #include <SDL.h>
 #include <SDL_ttf.h>
 
-#include <cassert>
-#include <iostream>
+#include <algorithm>
 #include <string>
-#include <vector>
 
 const int SIZE = 800;
 
 gds::Sdl gds::sdl = gds::Sdl("Snake", SIZE, SIZE);
 
-class Game {
-private:
-	StateManager stateManager;
-	State* state = stateManager.menuState.get();
-public:
-	void run() {
-		SDL_Event e;
-		bool quit = false;
-
-		uint32_t time = SDL_GetTicks();
-		while (!quit) {
-			while (SDL_PollEvent(&e)) {
-				if (e.type == SDL_QUIT)
-					quit = true;
-				else
-					state->handleEvent(e);
-			}
-
-			uint32_t deltaTime = SDL_GetTicks() - time;
-			time = SDL_GetTicks();
-			// State Manager
-			state = state->update(deltaTime);
-
-			SDL_SetRenderDrawColor(gds::sdl.renderer, 0xFF, 0x00, 0xFF, 0xFF);
-			SDL_RenderClear(gds::sdl.renderer);
-
-			state->render();
-
-			gds::sdl.renderPresent();
-		}
-	}
+struct Options {
+	gds::LoopSettings loop;
+	// games are recorded here
+	std::string replayDirectory = "replays";
+	// recorded game to show instead of the main menu
+	std::string replayPath;
+	// false draws the board cell by cell instead of as a texture
+	bool useBoardTexture = true;
+	// queued turns a tick takes, see PlayingState::turnsPerTick
+	uint32_t turnsPerTick = 1;
 };
 
+// --fps N (0 for unlimited), --vsync, --assert-no-alloc (abort when the playing state allocates after warmup),
+// --record-dir path, --no-record, --replay file, --board-rects, --turns-per-tick N
+Options parseOptions(int argc, char* args[]) {
+	Options options;
+	for (int ix = 1; ix < argc; ++ix) {
+		const std::string arg = args[ix];
+		if (arg == "--fps" && ix + 1 < argc)
+			options.loop.targetFps = std::stoi(args[++ix]);
+		else if (arg == "--vsync")
+			options.loop.vsync = true;
+		else if (arg == "--assert-no-alloc")
+			gds::allocationTracker.setAssertMode(true);
+		else if (arg == "--record-dir" && ix + 1 < argc)
+			options.replayDirectory = args[++ix];
+		else if (arg == "--no-record")
+			options.replayDirectory.clear();
+		else if (arg == "--replay" && ix + 1 < argc)
+			options.replayPath = args[++ix];
+		else if (arg == "--board-rects")
+			options.useBoardTexture = false;
+		else if (arg == "--turns-per-tick" && ix + 1 < argc)
+			options.turnsPerTick = static_cast<uint32_t>(std::max(1, std::stoi(args[++ix])));
+	}
+	return options;
+}
+
 int main(int argc, char* args[]) {
 	gds::sdl.loadFont(gds::DEFAULT_FONT, "assets/fonts/enter_command/EnterCommand.ttf", 28); // "c:\\Windows\\Fonts\\vgaoem.fon"; // arial.ttf"
 	gds::sdl.loadFont(gds::TITLE_FONT, "assets/fonts/enter_command/EnterCommand.ttf", 40);
 
-	Game game;
+	const Options options = parseOptions(argc, args);
+	Game game{ options.loop };
+	game.getStateManager().playingState->setReplayDirectory(options.replayDirectory);
+	game.getStateManager().playingState->useBoardTexture = options.useBoardTexture;
+	game.getStateManager().playingState->turnsPerTick = options.turnsPerTick;
+	if (!options.replayPath.empty() && !game.startReplay(options.replayPath))
+		return 1;
 	game.run();
 	return 0;
 }
\ No newline at end of file
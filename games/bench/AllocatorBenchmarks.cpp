@@ -0,0 +1,153 @@
+#include "Bench.h"
+
+#include <Cell.h>
+#include <FrameArena.h>
+#include <ObjectPool.h>
+#include <OccupancyGrid.h>
+
+#include <charconv>
+#include <list>
+#include <memory>
+#include <memory_resource>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+// The transient containers the game used to build per tick and per frame, on the heap and on the frame arena.
+// Each iteration ends with a reset of the arena, like a frame of the game loop.
+
+// the placeApple of old: collects the free cells of a half filled grid, then samples one
+template<typename Vector>
+Cell sampleFreeCell(const OccupancyGrid& grid, Vector& cells, std::mt19937& rnd) {
+	const int32_t gridSize = grid.getGridSize();
+	for (int32_t y = 0; y < gridSize; ++y)
+		for (int32_t x = 0; x < gridSize; ++x)
+			if (grid.isEmpty({ x, y }))
+				cells.push_back({ x, y });
+	return cells[std::uniform_int_distribution<size_t>(0, cells.size() - 1)(rnd)];
+}
+
+std::shared_ptr<OccupancyGrid> makeHalfFilledGrid(int32_t gridSize) {
+	auto grid = std::make_shared<OccupancyGrid>(gridSize);
+	for (int32_t y = 0; y < gridSize; y += 2)
+		for (int32_t x = 0; x < gridSize; ++x)
+			grid->set({ x, y }, OccupancyGrid::Content::SNAKE);
+	return grid;
+}
+
+// longer than the small string buffer, so that the heap version really allocates
+template<typename String>
+void formatStatus(String& text, uint32_t score, uint32_t length) {
+	char number[16];
+	text += "score: ";
+	text.append(number, std::to_chars(number, number + sizeof(number), score).ptr);
+	text += "   length: ";
+	text.append(number, std::to_chars(number, number + sizeof(number), length).ptr);
+}
+
+// about the size of a widget
+struct Payload {
+	uint64_t values[8];
+};
+
+}
+
+void registerAllocatorBenchmarks(bench::Runner& runner) {
+	// as a game would own one, reset once per frame
+	auto arena = std::make_shared<gds::FrameArena>(64 * 1024);
+	for (int32_t gridSize : { 20, 40 }) {
+		const std::string suffix = "/" + std::to_string(gridSize);
+		auto grid = makeHalfFilledGrid(gridSize);
+
+		runner.add("freeCells vector/heap" + suffix, [grid](uint64_t iterations) {
+			std::mt19937 rnd{ 42 };
+			for (uint64_t ix = 0; ix < iterations; ++ix) {
+				std::vector<Cell> cells;
+				bench::doNotOptimize(sampleFreeCell(*grid, cells, rnd));
+			}
+		});
+
+		runner.add("freeCells vector/frameArena" + suffix, [grid, arena](uint64_t iterations) {
+			std::mt19937 rnd{ 42 };
+			for (uint64_t ix = 0; ix < iterations; ++ix) {
+				{
+					std::pmr::vector<Cell> cells{ arena.get() };
+					bench::doNotOptimize(sampleFreeCell(*grid, cells, rnd));
+				}
+				arena->reset();
+			}
+		});
+	}
+
+	runner.add("status string/heap", [](uint64_t iterations) {
+		for (uint64_t ix = 0; ix < iterations; ++ix) {
+			std::string text;
+			formatStatus(text, static_cast<uint32_t>(ix), 1234);
+			bench::doNotOptimize(text.data());
+		}
+	});
+
+	runner.add("status string/frameArena", [arena](uint64_t iterations) {
+		for (uint64_t ix = 0; ix < iterations; ++ix) {
+			{
+				std::pmr::string text{ arena.get() };
+				formatStatus(text, static_cast<uint32_t>(ix), 1234);
+				bench::doNotOptimize(text.data());
+			}
+			arena->reset();
+		}
+	});
+
+	// 64 objects alive at once, allocated and freed in a shuffled order
+	constexpr uint64_t LIVE = 64;
+	runner.add("Payload new+delete/heap", [](uint64_t iterations) {
+		std::vector<Payload*> live(LIVE, nullptr);
+		for (uint64_t ix = 0; ix < iterations; ++ix) {
+			Payload*& slot = live[(ix * 37) % LIVE];
+			delete slot;
+			slot = new Payload{};
+			bench::doNotOptimize(slot);
+		}
+		for (Payload* payload : live)
+			delete payload;
+	});
+
+	runner.add("Payload create+destroy/ObjectPool", [](uint64_t iterations) {
+		gds::ObjectPool<Payload> pool;
+		std::vector<Payload*> live(LIVE, nullptr);
+		for (uint64_t ix = 0; ix < iterations; ++ix) {
+			Payload*& slot = live[(ix * 37) % LIVE];
+			pool.destroy(slot);
+			slot = pool.create();
+			bench::doNotOptimize(slot);
+		}
+		for (Payload* payload : live)
+			pool.destroy(payload);
+	});
+
+	// node container through the pool's std::pmr interface, timing is per node
+	constexpr uint64_t NODES = 256;
+	runner.add("list<Cell> push+clear/heap", [](uint64_t iterations) {
+		std::list<Cell> cells;
+		for (uint64_t ix = 0; ix < iterations; ++ix) {
+			for (uint64_t nx = 0; nx < NODES; ++nx)
+				cells.push_back({ static_cast<int32_t>(nx), 0 });
+			bench::doNotOptimize(cells.back());
+			cells.clear();
+		}
+	}, NODES);
+
+	runner.add("list<Cell> push+clear/BlockPool", [](uint64_t iterations) {
+		// node size of the list is an implementation detail, blocks of four pointers fit it
+		gds::BlockPool pool{ 4 * sizeof(void*), alignof(std::max_align_t) };
+		std::pmr::list<Cell> cells{ &pool };
+		for (uint64_t ix = 0; ix < iterations; ++ix) {
+			for (uint64_t nx = 0; nx < NODES; ++nx)
+				cells.push_back({ static_cast<int32_t>(nx), 0 });
+			bench::doNotOptimize(cells.back());
+			cells.clear();
+		}
+	}, NODES);
+}
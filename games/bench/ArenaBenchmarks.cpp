@@ -0,0 +1,197 @@
+#include "Bench.h"
+
+#include <Arena.h>
+#include <Rng.h>
+
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// the arena before a tick, as plain vectors
+struct Before {
+	std::vector<std::vector<Cell>> bodies;
+	std::vector<Direction> dirs;
+	std::vector<Cell> apples;
+};
+
+Before capture(const sim::Arena& arena) {
+	Before before;
+	for (uint32_t snake = 0; snake < arena.getSnakeCount(); ++snake) {
+		const sim::ArenaSnake& current = arena.getSnake(snake);
+		before.bodies.emplace_back(current.cells.begin(), current.cells.end());
+		before.dirs.push_back(current.dir);
+	}
+	before.apples = arena.getApples();
+	return before;
+}
+
+// The rules of Arena the slow way: every head against every segment of every snake, every head against every other head.
+std::vector<sim::ArenaOutcome> resolveByScanning(const Before& before, const std::vector<sim::Action>& actions, int32_t gridSize) {
+	const size_t count = before.bodies.size();
+	std::vector<sim::ArenaOutcome> outcomes(count, sim::ArenaOutcome::MOVED);
+	std::vector<Cell> next(count);
+	std::vector<bool> isGrowing(count, false);
+	for (size_t snake = 0; snake < count; ++snake) {
+		if (before.bodies[snake].empty()) {
+			outcomes[snake] = sim::ArenaOutcome::NOT_PLAYING;
+			continue;
+		}
+		const Direction dir = sim::turned(before.dirs[snake], actions[snake]);
+		next[snake] = before.bodies[snake].front().addCell(Cell::deltaCell(dir));
+		if (next[snake].x < 0 || next[snake].y < 0 || next[snake].x >= gridSize || next[snake].y >= gridSize) {
+			outcomes[snake] = sim::ArenaOutcome::HIT_WALL;
+			continue;
+		}
+		for (const Cell& apple : before.apples)
+			isGrowing[snake] = isGrowing[snake] || apple.isSameAs(next[snake]);
+	}
+	for (size_t a = 0; a < count; ++a)
+		for (size_t b = a + 1; b < count; ++b)
+			if (outcomes[a] != sim::ArenaOutcome::NOT_PLAYING && outcomes[a] != sim::ArenaOutcome::HIT_WALL
+				&& outcomes[b] != sim::ArenaOutcome::NOT_PLAYING && outcomes[b] != sim::ArenaOutcome::HIT_WALL && next[a].isSameAs(next[b])) {
+				outcomes[a] = sim::ArenaOutcome::HEAD_ON;
+				outcomes[b] = sim::ArenaOutcome::HEAD_ON;
+				isGrowing[a] = false;
+				isGrowing[b] = false;
+			}
+	for (size_t snake = 0; snake < count; ++snake) {
+		if (outcomes[snake] != sim::ArenaOutcome::MOVED)
+			continue;
+		for (size_t other = 0; other < count; ++other) {
+			const std::vector<Cell>& body = before.bodies[other];
+			for (size_t ix = 0; ix < body.size(); ++ix) {
+				const bool isVacated = ix + 1 == body.size() && !isGrowing[other];
+				if (body[ix].isSameAs(next[snake]) && !isVacated)
+					outcomes[snake] = other == snake ? sim::ArenaOutcome::BIT_ITSELF : sim::ArenaOutcome::HIT_SNAKE;
+			}
+		}
+		if (outcomes[snake] == sim::ArenaOutcome::MOVED && isGrowing[snake])
+			outcomes[snake] = sim::ArenaOutcome::ATE_APPLE;
+	}
+	return outcomes;
+}
+
+// mostly the bots, some random turns so that snakes crash into each other
+void chooseActions(const sim::Arena& arena, Rng& rng, std::vector<sim::Action>& actions) {
+	for (uint32_t snake = 0; snake < arena.getSnakeCount(); ++snake) {
+		const uint32_t roll = rng.nextBelow(16);
+		actions[snake] = roll == 0 ? sim::Action::TURN_LEFT : roll == 1 ? sim::Action::TURN_RIGHT : sim::chooseBotAction(arena, snake, rng);
+	}
+}
+
+// every cell of every living snake and every apple is indexed under its owner, and nothing else is
+int checkIndex(const sim::Arena& arena) {
+	int mismatches = 0;
+	size_t segments = 0;
+	for (uint32_t snake = 0; snake < arena.getSnakeCount(); ++snake) {
+		const sim::ArenaSnake& current = arena.getSnake(snake);
+		segments += current.isAlive ? current.cells.size() : 0;
+		for (const Cell& cell : current.cells)
+			mismatches += current.isAlive && arena.getOccupant(cell) == snake ? 0 : 1;
+	}
+	for (uint32_t apple = 0; apple < arena.getApples().size(); ++apple)
+		mismatches += arena.getOccupant(arena.getApples()[apple]) == (sim::Arena::APPLE_FLAG | apple) ? 0 : 1;
+	return mismatches + (segments == arena.getSegmentCount() ? 0 : 1);
+}
+
+}
+
+// Plays a crowded arena with one and with several threads. Every tick is resolved again by scanning all bodies and
+// compared, the spatial index is checked against the bodies, and both arenas have to play the same game.
+// Returns the number of mismatches.
+int verifyArena() {
+	int mismatches = 0;
+	sim::ArenaSettings settings;
+	settings.gridSize = 24;
+	settings.snakeCount = 80;
+	settings.appleCount = 30;
+	settings.seed = 5;
+	sim::Arena arena{ settings };
+	settings.threadCount = 4;
+	sim::Arena threaded{ settings };
+
+	Rng rng{ 6 };
+	std::vector<sim::Action> actions(settings.snakeCount);
+	uint64_t deaths = 0;
+	uint64_t headOns = 0;
+	for (int tick = 0; tick < 2000; ++tick) {
+		chooseActions(arena, rng, actions);
+		const Before before = capture(arena);
+		const std::vector<sim::ArenaOutcome> expected = resolveByScanning(before, actions, settings.gridSize);
+		arena.step(actions.data());
+		threaded.step(actions.data());
+
+		for (uint32_t snake = 0; snake < settings.snakeCount; ++snake) {
+			const sim::ArenaOutcome outcome = arena.getOutcomes()[snake];
+			deaths += sim::isDeath(outcome) ? 1 : 0;
+			headOns += outcome == sim::ArenaOutcome::HEAD_ON ? 1 : 0;
+			if ((outcome != expected[snake] || outcome != threaded.getOutcomes()[snake]
+				|| !arena.getSnake(snake).cells.isEmpty() != !threaded.getSnake(snake).cells.isEmpty()) && mismatches++ < 10)
+				std::printf("Arena mismatch at tick %d, snake %u: outcome %d, expected %d\n", tick, snake, static_cast<int>(outcome), static_cast<int>(expected[snake]));
+			// a snake that lived on is its old body with the new head, minus the tail unless it ate
+			if (outcome == sim::ArenaOutcome::MOVED || outcome == sim::ArenaOutcome::ATE_APPLE) {
+				const gds::RingBuffer<Cell>& cells = arena.getSnake(snake).cells;
+				const std::vector<Cell>& old = before.bodies[snake];
+				const size_t length = old.size() + (outcome == sim::ArenaOutcome::ATE_APPLE ? 1 : 0);
+				bool isSame = cells.size() == length && cells.front().isSameAs(threaded.getSnake(snake).cells.front());
+				for (size_t ix = 1; ix < length && isSame; ++ix)
+					isSame = cells[ix].isSameAs(old[ix - 1]);
+				mismatches += isSame ? 0 : 1;
+			}
+		}
+		mismatches += checkIndex(arena) + checkIndex(threaded);
+	}
+	std::printf("Arena: %u snakes, 2000 ticks, %llu deaths, %llu head on, %zu segments, %d mismatches\n", settings.snakeCount,
+		static_cast<unsigned long long>(deaths), static_cast<unsigned long long>(headOns), arena.getSegmentCount(), mismatches);
+	return mismatches;
+}
+
+// Ticks of bot arenas of growing size at the same density, timing is per snake. Against resolving the same ticks by scanning.
+void registerArenaBenchmarks(bench::Runner& runner) {
+	std::vector<uint32_t> threadCounts{ 1 };
+	if (std::thread::hardware_concurrency() > 1)
+		threadCounts.push_back(std::thread::hardware_concurrency());
+
+	for (uint32_t snakeCount : { 100u, 1000u, 10000u }) {
+		for (uint32_t threads : threadCounts) {
+			sim::ArenaSettings settings;
+			settings.snakeCount = snakeCount;
+			settings.appleCount = snakeCount;
+			// 100 cells per snake
+			settings.gridSize = static_cast<int32_t>(std::sqrt(snakeCount * 100.0));
+			settings.threadCount = threads;
+			auto arena = std::make_shared<sim::Arena>(settings);
+			auto actions = std::make_shared<std::vector<sim::Action>>(snakeCount);
+			auto rng = std::make_shared<Rng>(7);
+			runner.add("Arena::step/" + std::to_string(snakeCount) + "/threads:" + std::to_string(threads), [arena, actions, rng](uint64_t iterations) {
+				for (uint64_t ix = 0; ix < iterations; ++ix) {
+					chooseActions(*arena, *rng, *actions);
+					arena->step(actions->data());
+				}
+				bench::doNotOptimize(arena->getSegmentCount());
+			}, snakeCount);
+		}
+	}
+
+	for (uint32_t snakeCount : { 100u, 1000u }) {
+		sim::ArenaSettings settings;
+		settings.snakeCount = snakeCount;
+		settings.appleCount = snakeCount;
+		settings.gridSize = static_cast<int32_t>(std::sqrt(snakeCount * 100.0));
+		auto arena = std::make_shared<sim::Arena>(settings);
+		auto actions = std::make_shared<std::vector<sim::Action>>(snakeCount);
+		auto rng = std::make_shared<Rng>(7);
+		runner.add("Arena scanning/" + std::to_string(snakeCount), [arena, actions, rng, gridSize = settings.gridSize](uint64_t iterations) {
+			for (uint64_t ix = 0; ix < iterations; ++ix) {
+				chooseActions(*arena, *rng, *actions);
+				bench::doNotOptimize(resolveByScanning(capture(*arena), *actions, gridSize).data());
+				arena->step(actions->data());
+			}
+		}, snakeCount);
+	}
+}
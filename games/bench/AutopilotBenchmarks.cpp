@@ -0,0 +1,231 @@
+#include "Bench.h"
+
+#include <Autopilot.h>
+#include <Simulation.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+// distances from the apple around the body, from scratch
+void searchFromApple(const sim::State& state, std::vector<uint32_t>& distances, std::vector<Cell>& queue) {
+	const OccupancyGrid& grid = state.snake.getGrid();
+	const int32_t gridSize = grid.getGridSize();
+	distances.assign(static_cast<size_t>(gridSize) * gridSize, sim::Autopilot::UNREACHABLE);
+	queue.clear();
+	if (!state.hasApple)
+		return;
+	distances[static_cast<size_t>(state.apple.y) * gridSize + state.apple.x] = 0;
+	queue.push_back(state.apple);
+	for (size_t ix = 0; ix < queue.size(); ++ix) {
+		const Cell cell = queue[ix];
+		const uint32_t distance = distances[static_cast<size_t>(cell.y) * gridSize + cell.x] + 1;
+		for (const Direction dir : { Direction::UP, Direction::RIGHT, Direction::DOWN, Direction::LEFT }) {
+			const Cell next = cell.addCell(Cell::deltaCell(dir));
+			if (!grid.isEmpty(next) || distances[static_cast<size_t>(next.y) * gridSize + next.x] != sim::Autopilot::UNREACHABLE)
+				continue;
+			distances[static_cast<size_t>(next.y) * gridSize + next.x] = distance;
+			queue.push_back(next);
+		}
+	}
+}
+
+struct Match {
+	// games that filled the grid or died
+	uint64_t games{};
+	uint64_t deaths{};
+	uint64_t decisions{};
+	uint64_t scores{};
+	// score of the game the clock cut off, not in the average
+	bool isCutOff = false;
+	uint32_t cutOffScore{};
+	double seconds{};
+};
+
+// Games on one grid back to back until the time is up, the last one is cut off by the clock
+Match playAgainstClock(int32_t gridSize, double seconds, uint64_t seed) {
+	Match match;
+	sim::Autopilot autopilot;
+	autopilot.reserve(gridSize);
+	const auto start = std::chrono::steady_clock::now();
+	while (!match.isCutOff) {
+		sim::State state{ gridSize, Rng{ seed + match.games } };
+		bool isOver = false;
+		while (!isOver && state.hasApple) {
+			// the clock is read every 1024 decisions
+			for (int ix = 0; ix < 1024 && !isOver && state.hasApple; ++ix) {
+				isOver = sim::isGameOver(sim::step(state, autopilot.choose(state)));
+				++match.decisions;
+			}
+			match.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			if (match.seconds >= seconds)
+				break;
+		}
+		if (!isOver && state.hasApple) {
+			match.isCutOff = true;
+			match.cutOffScore = state.score;
+			break;
+		}
+		++match.games;
+		match.deaths += isOver ? 1 : 0;
+		match.scores += state.score;
+	}
+	return match;
+}
+
+struct TickTimes {
+	uint64_t ticks{};
+	double medianUs{};
+	double p99Us{};
+	double maxUs{};
+};
+
+// Times every decision of one long game, the field builds and updates as the body grows
+TickTimes timeTicks(int32_t gridSize, uint64_t ticks, uint64_t seed) {
+	sim::Autopilot autopilot;
+	autopilot.reserve(gridSize);
+	sim::State state{ gridSize, Rng{ seed } };
+	std::vector<double> times;
+	times.reserve(ticks);
+	bool isOver = false;
+	while (!isOver && state.hasApple && times.size() < ticks) {
+		const auto start = std::chrono::steady_clock::now();
+		const sim::Action action = autopilot.choose(state);
+		times.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+		isOver = sim::isGameOver(sim::step(state, action));
+	}
+	std::sort(times.begin(), times.end());
+	TickTimes result;
+	result.ticks = times.size();
+	if (!times.empty()) {
+		result.medianUs = times[times.size() / 2];
+		result.p99Us = times[times.size() * 99 / 100];
+		result.maxUs = times.back();
+	}
+	return result;
+}
+
+}
+
+// Follows the Hamiltonian cycle from every cell. Plays whole games on small grids, even and odd, which the autopilot
+// has to fill without dying. Checks the distance field against a search from scratch after every tick, with builds
+// spread over several ticks. Then the autopilot against the clock, decisions per second and the average score of the
+// games that ended, and the time of a decision over a long game: median, p99 and max. Returns the number of mismatches.
+int verifyAutopilot() {
+	int mismatches = 0;
+	// every cell's cycle direction leads to the next position
+	for (int32_t gridSize = 2; gridSize <= 21; ++gridSize) {
+		const sim::HamiltonianCycle cycle{ gridSize };
+		for (int32_t y = 0; y < gridSize; ++y) {
+			for (int32_t x = 0; x < gridSize; ++x) {
+				const Cell cell{ x, y };
+				const Cell next = cell.addCell(Cell::deltaCell(cycle.getDirection(cell)));
+				const bool isInside = next.x >= 0 && next.y >= 0 && next.x < gridSize && next.y < gridSize;
+				if ((!isInside || cycle.getDistance(cycle.getPosition(cell), cycle.getPosition(next)) != 1) && mismatches++ < 10)
+					std::printf("Cycle of grid %d leaves (%d, %d) the wrong way\n", gridSize, x, y);
+			}
+		}
+	}
+
+	for (int32_t gridSize : { 4, 5, 10, 15, 20 }) {
+		for (uint64_t seed = 1; seed <= 3; ++seed) {
+			sim::State state{ gridSize, Rng{ seed } };
+			sim::Autopilot autopilot;
+			autopilot.reserve(gridSize);
+			bool isOver = false;
+			const uint64_t maxTicks = static_cast<uint64_t>(gridSize) * gridSize * gridSize * gridSize * 2;
+			while (!isOver && state.hasApple && state.ticks < maxTicks)
+				isOver = sim::isGameOver(sim::step(state, autopilot.choose(state)));
+			const uint32_t fullScore = static_cast<uint32_t>(gridSize * gridSize - 2);
+			if (state.score != fullScore && mismatches++ < 10)
+				std::printf("Autopilot did not fill grid %d, seed %llu: score %u of %u after %llu ticks%s\n", gridSize,
+					static_cast<unsigned long long>(seed), state.score, fullScore, static_cast<unsigned long long>(state.ticks), isOver ? ", died" : "");
+		}
+	}
+
+	std::vector<uint32_t> expected;
+	std::vector<Cell> queue;
+	uint64_t checkedTicks = 0;
+	for (int32_t gridSize : { 24, 33 }) {
+		sim::State state{ gridSize, Rng{ 9 } };
+		// a build takes a few ticks, the body moves meanwhile
+		sim::Autopilot autopilot{ 97 };
+		autopilot.reserve(gridSize);
+		bool isOver = false;
+		const uint64_t maxTicks = static_cast<uint64_t>(gridSize) * gridSize * gridSize * gridSize * 2;
+		while (!isOver && state.hasApple && state.ticks < maxTicks) {
+			const sim::Action action = autopilot.choose(state);
+			if (autopilot.isFieldReady()) {
+				++checkedTicks;
+				searchFromApple(state, expected, queue);
+				int wrong = 0;
+				for (int32_t y = 0; y < gridSize; ++y)
+					for (int32_t x = 0; x < gridSize; ++x)
+						wrong += autopilot.getDistance(Cell{ x, y }) == expected[static_cast<size_t>(y) * gridSize + x] ? 0 : 1;
+				if (wrong > 0 && mismatches++ < 10)
+					std::printf("Autopilot field on grid %d at tick %llu: %d cells differ from a new search\n", gridSize, static_cast<unsigned long long>(state.ticks), wrong);
+			}
+			isOver = sim::isGameOver(sim::step(state, action));
+		}
+	}
+	std::printf("Autopilot: filled grids of 4 to 20, field checked on %llu ticks, %d mismatches\n", static_cast<unsigned long long>(checkedTicks), mismatches);
+
+	for (int32_t gridSize : { 20, 1000 }) {
+		const Match match = playAgainstClock(gridSize, 0.5, 1);
+		mismatches += static_cast<int>(match.deaths);
+		std::printf("Autopilot vs clock/%d: %llu games in %.2f s, %.0f decisions/s, ", gridSize, static_cast<unsigned long long>(match.games),
+			match.seconds, match.decisions / match.seconds);
+		if (match.games > 0)
+			std::printf("average score %.1f, ", static_cast<double>(match.scores) / match.games);
+		if (match.isCutOff)
+			std::printf("partial score %u when the time ran out, ", match.cutOffScore);
+		std::printf("%llu deaths\n", static_cast<unsigned long long>(match.deaths));
+	}
+
+	for (int32_t gridSize : { 200, 1000 }) {
+		const TickTimes times = timeTicks(gridSize, 100000, 5);
+		std::printf("Autopilot ticks/%d: %llu ticks, median %.1f us, p99 %.1f us, max %.1f us\n", gridSize,
+			static_cast<unsigned long long>(times.ticks), times.medianUs, times.p99Us, times.maxUs);
+	}
+	return mismatches;
+}
+
+// A decision and a step of an autopilot game, games back to back. The large grid plays one long game across the
+// repetitions, a tick costs more the longer the game goes on. Against searching the field from scratch.
+void registerAutopilotBenchmarks(bench::Runner& runner) {
+	auto autopilot = std::make_shared<sim::Autopilot>();
+	autopilot->reserve(40);
+	auto state = std::make_shared<sim::State>(40, Rng{ 3 });
+	runner.add("Autopilot::choose+step/40", [autopilot, state](uint64_t iterations) {
+		for (uint64_t ix = 0; ix < iterations; ++ix) {
+			if (!state->hasApple || sim::isGameOver(sim::step(*state, autopilot->choose(*state))))
+				*state = sim::State{ 40, state->rng };
+		}
+		bench::doNotOptimize(state->score);
+	});
+
+	auto large = std::make_shared<sim::Autopilot>();
+	large->reserve(1000);
+	auto game = std::make_shared<sim::State>(1000, Rng{ 3 });
+	runner.add("Autopilot::choose+step/1000", [large, game](uint64_t iterations) {
+		for (uint64_t ix = 0; ix < iterations; ++ix) {
+			if (!game->hasApple || sim::isGameOver(sim::step(*game, large->choose(*game))))
+				*game = sim::State{ 1000, game->rng };
+		}
+		bench::doNotOptimize(game->score);
+	});
+
+	auto scratch = std::make_shared<sim::State>(1000, Rng{ 3 });
+	auto distances = std::make_shared<std::vector<uint32_t>>();
+	auto queue = std::make_shared<std::vector<Cell>>();
+	runner.add("field from scratch/1000", [scratch, distances, queue](uint64_t iterations) {
+		for (uint64_t ix = 0; ix < iterations; ++ix)
+			searchFromApple(*scratch, *distances, *queue);
+		bench::doNotOptimize(distances->data());
+	});
+}
@@ -0,0 +1,157 @@
+#include "Bench.h"
+#include "Policies.h"
+
+#include <BatchSim.h>
+#include <Rng.h>
+#include <Simulation.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// half of the games follow the Hamiltonian cycle (long games that can fill the grid), the other half turn at random
+sim::Action policy(uint32_t game, Direction dir, const Cell& head, int32_t gridSize, Rng& rng) {
+	if (game % 2 == 0)
+		return bench::actionToward(dir, bench::cycleDirection(head, gridSize));
+	const uint32_t roll = rng.nextBelow(8);
+	return roll == 0 ? sim::Action::TURN_LEFT : roll == 1 ? sim::Action::TURN_RIGHT : sim::Action::NONE;
+}
+
+void useApple(sim::State& state, const Cell& apple) {
+	state.apple = apple;
+	state.hasApple = true;
+}
+
+}
+
+// Steps the batch and one scalar sim::State per game with the same actions and compares them after every step.
+// Apples are copied from the batch into the scalar games: the batch samples differently, every other rule has to match.
+// Returns the number of mismatches.
+int verifyBatchSim() {
+	constexpr uint32_t GAMES = 512;
+	constexpr uint32_t STEPS = 20000;
+	constexpr int32_t GRID_SIZE = 8;
+	sim::BatchSim batch{ { GAMES, GRID_SIZE, 7, 0 } };
+
+	std::vector<sim::State> games;
+	games.reserve(GAMES);
+	for (uint32_t game = 0; game < GAMES; ++game) {
+		games.emplace_back(GRID_SIZE, Rng{ 7, game });
+		useApple(games.back(), batch.getApple(game));
+	}
+
+	Rng rng{ 99 };
+	std::vector<sim::Action> actions(GAMES);
+	int mismatches = 0;
+	uint64_t gameOvers = 0;
+	uint64_t filledGrids = 0;
+	for (uint32_t step = 0; step < STEPS && mismatches < 10; ++step) {
+		for (uint32_t game = 0; game < GAMES; ++game)
+			actions[game] = policy(game, batch.getDirection(game), batch.getHead(game), GRID_SIZE, rng);
+		batch.step(actions.data());
+
+		for (uint32_t game = 0; game < GAMES; ++game) {
+			sim::State& state = games[game];
+			const sim::Outcome outcome = sim::step(state, actions[game]);
+			bool isMatch = outcome == batch.getOutcomes()[game];
+
+			const bool isFilled = outcome == sim::Outcome::ATE_APPLE && !state.hasApple;
+			if (sim::isGameOver(outcome) || isFilled) {
+				gameOvers += sim::isGameOver(outcome) ? 1 : 0;
+				filledGrids += isFilled ? 1 : 0;
+				state = sim::State{ GRID_SIZE, state.rng };
+				useApple(state, batch.getApple(game));
+			}
+			else if (outcome == sim::Outcome::ATE_APPLE) {
+				isMatch = isMatch && state.snake.getGrid().isEmpty(batch.getApple(game));
+				useApple(state, batch.getApple(game));
+			}
+
+			isMatch = isMatch && state.snake.getHead().isSameAs(batch.getHead(game)) && state.snake.getDirection() == batch.getDirection(game)
+				&& state.snake.getCells().size() == batch.getLength(game) && state.score == batch.getScore(game)
+				&& batch.isSnake(game, state.snake.getTail());
+			if (!isMatch && mismatches++ < 10)
+				std::printf("BatchSim mismatch: game %u, step %u\n", game, step);
+		}
+	}
+	std::printf("BatchSim vs sim::step: %u games x %u steps, %llu game overs, %llu filled grids, %d mismatches\n", GAMES, STEPS,
+		static_cast<unsigned long long>(gameOvers), static_cast<unsigned long long>(filledGrids), mismatches);
+
+	// the kernels compiled for a grid size play the same games as the generic ones
+	for (int32_t gridSize : { 10, 20, 40 }) {
+		constexpr uint32_t KERNEL_GAMES = 256;
+		constexpr uint32_t KERNEL_STEPS = 5000;
+		sim::BatchSim specialized{ { KERNEL_GAMES, gridSize, 3, 1, true } };
+		sim::BatchSim generic{ { KERNEL_GAMES, gridSize, 3, 1, false } };
+		int differences = 0;
+		for (uint32_t step = 0; step < KERNEL_STEPS; ++step) {
+			for (uint32_t game = 0; game < KERNEL_GAMES; ++game)
+				actions[game] = policy(game, specialized.getDirection(game), specialized.getHead(game), gridSize, rng);
+			specialized.step(actions.data());
+			generic.step(actions.data());
+			for (uint32_t game = 0; game < KERNEL_GAMES; ++game)
+				differences += specialized.getOutcomes()[game] == generic.getOutcomes()[game] && specialized.getHead(game).isSameAs(generic.getHead(game))
+					&& specialized.getLength(game) == generic.getLength(game) && specialized.getApple(game).isSameAs(generic.getApple(game))
+					&& specialized.isSnake(game, specialized.getApple(game)) == generic.isSnake(game, generic.getApple(game)) ? 0 : 1;
+		}
+		std::printf("BatchSim Grid<%d, %d> vs generic: %u games x %u steps, %d mismatches\n", gridSize, gridSize, KERNEL_GAMES, KERNEL_STEPS, differences);
+		mismatches += differences;
+	}
+	return mismatches;
+}
+
+// Timing is per game step. Steps per second and core: 1e9 / (ns * threads).
+void registerBatchBenchmarks(bench::Runner& runner) {
+	constexpr uint32_t GAMES = 16384;
+	constexpr int32_t GRID_SIZE = 20;
+	// actions are drawn up front, a few different ones per step
+	constexpr uint32_t ACTION_SETS = 16;
+	auto actions = std::make_shared<std::vector<sim::Action>>(static_cast<size_t>(GAMES) * ACTION_SETS);
+	Rng rng{ 5 };
+	for (sim::Action& action : *actions) {
+		const uint32_t roll = rng.nextBelow(8);
+		action = roll == 0 ? sim::Action::TURN_LEFT : roll == 1 ? sim::Action::TURN_RIGHT : sim::Action::NONE;
+	}
+
+	std::vector<uint32_t> threadCounts{ 1 };
+	const uint32_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+	if (hardwareThreads > 1)
+		threadCounts.push_back(hardwareThreads);
+	for (uint32_t threads : threadCounts) {
+		auto batch = std::make_shared<sim::BatchSim>(sim::BatchSettings{ GAMES, GRID_SIZE, 1, threads });
+		runner.add("BatchSim::step/" + std::to_string(GAMES) + " games/" + std::to_string(threads) + " threads", [batch, actions](uint64_t iterations) {
+			for (uint64_t ix = 0; ix < iterations; ++ix)
+				batch->step(actions->data() + (ix % ACTION_SETS) * GAMES);
+			bench::doNotOptimize(batch->getOutcomes()[0]);
+		}, GAMES);
+	}
+
+	// the kernels compiled for the grid sizes of the settings against the generic ones, one thread
+	constexpr uint32_t KERNEL_GAMES = 4096;
+	for (int32_t gridSize : { 10, 20, 40 }) {
+		for (bool isSpecialized : { true, false }) {
+			auto batch = std::make_shared<sim::BatchSim>(sim::BatchSettings{ KERNEL_GAMES, gridSize, 1, 1, isSpecialized });
+			runner.add("BatchSim::step/grid " + std::to_string(gridSize) + (isSpecialized ? "/specialized" : "/generic"), [batch, actions](uint64_t iterations) {
+				for (uint64_t ix = 0; ix < iterations; ++ix)
+					batch->step(actions->data() + (ix % ACTION_SETS) * GAMES);
+				bench::doNotOptimize(batch->getOutcomes()[0]);
+			}, KERNEL_GAMES);
+		}
+	}
+
+	// the scalar rules, one game after the other, for comparison
+	runner.add("sim::step/random", [actions](uint64_t iterations) {
+		sim::State state{ GRID_SIZE, Rng{ 1 } };
+		for (uint64_t ix = 0; ix < iterations; ++ix) {
+			const sim::Outcome outcome = sim::step(state, (*actions)[ix % actions->size()]);
+			if (sim::isGameOver(outcome) || !state.hasApple)
+				state = sim::State{ GRID_SIZE, state.rng };
+		}
+		bench::doNotOptimize(state.score);
+	});
+}
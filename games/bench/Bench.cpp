@@ -0,0 +1,188 @@
+#include "Bench.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <unordered_map>
+
+namespace bench {
+
+namespace {
+
+double elapsedNs(const std::function<void(uint64_t)>& run, uint64_t iterations) {
+	const auto start = std::chrono::steady_clock::now();
+	run(iterations);
+	const auto end = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+// reads the medians of a previous run, only understands the JSON that writeJson() produces
+std::unordered_map<std::string, double> readBaseline(const std::string& path) {
+	std::unordered_map<std::string, double> medians;
+	std::ifstream in{ path };
+	if (!in) {
+		std::cerr << "Could not open baseline " << path << "\n";
+		return medians;
+	}
+	std::stringstream buffer;
+	buffer << in.rdbuf();
+	const std::string json = buffer.str();
+
+	const std::string nameKey = "\"name\": \"";
+	const std::string medianKey = "\"median_ns\": ";
+	size_t pos = 0;
+	while ((pos = json.find(nameKey, pos)) != std::string::npos) {
+		pos += nameKey.size();
+		const size_t nameEnd = json.find('"', pos);
+		const size_t medianPos = json.find(medianKey, nameEnd);
+		if (nameEnd == std::string::npos || medianPos == std::string::npos)
+			break;
+		medians[json.substr(pos, nameEnd - pos)] = std::stod(json.substr(medianPos + medianKey.size()));
+		pos = medianPos;
+	}
+	return medians;
+}
+
+void writeJson(const std::string& path, const Settings& settings, const std::vector<Result>& results) {
+	std::ofstream out{ path };
+	if (!out) {
+		std::cerr << "Could not open " << path << " to write results\n";
+		return;
+	}
+	out << "{\n  \"repetitions\": " << settings.repetitions << ",\n  \"min_repetition_ms\": " << settings.minRepetitionMs << ",\n  \"benchmarks\": [";
+	for (size_t ix = 0; ix < results.size(); ++ix) {
+		const Result& r = results[ix];
+		out << (ix == 0 ? "\n" : ",\n")
+			<< "    {\"name\": \"" << r.name << "\", \"iterations\": " << r.iterations
+			<< ", \"min_ns\": " << r.minNs << ", \"median_ns\": " << r.medianNs << ", \"mean_ns\": " << r.meanNs
+			<< ", \"stddev_ns\": " << r.stdDevNs << ", \"max_ns\": " << r.maxNs << "}";
+	}
+	out << "\n  ]\n}\n";
+}
+
+}
+
+//------------- Settings
+
+Settings Settings::fromArgs(int argc, char* args[]) {
+	Settings settings;
+	for (int ix = 1; ix < argc; ++ix) {
+		const std::string arg = args[ix];
+		if (arg == "--verify") {
+			settings.isVerifying = true;
+			continue;
+		}
+		if (ix + 1 == argc)
+			break;
+		const std::string val = args[ix + 1];
+		if (arg == "--filter")
+			settings.filter = val;
+		else if (arg == "--repetitions")
+			settings.repetitions = std::max(1, std::stoi(val));
+		else if (arg == "--min-time-ms")
+			settings.minRepetitionMs = std::stod(val);
+		else if (arg == "--json")
+			settings.jsonPath = val;
+		else if (arg == "--baseline")
+			settings.baselinePath = val;
+		else
+			continue;
+		++ix;
+	}
+	return settings;
+}
+
+
+//------------- Runner
+
+Runner::Runner(const Settings& settings) : settings(settings) {}
+
+void Runner::add(const std::string& name, std::function<void(uint64_t iterations)> run, uint64_t itemsPerIteration) {
+	benchmarks.push_back({ name, std::move(run), itemsPerIteration });
+}
+
+void Runner::addCheck(const std::string& name, std::function<int()> run) {
+	checks.push_back({ name, std::move(run) });
+}
+
+Result Runner::measure(const Benchmark& benchmark) const {
+	// Calibration: double the iterations until a repetition takes long enough, this also warms caches up
+	const double minNs = settings.minRepetitionMs * 1e6;
+	uint64_t iterations = 1;
+	double ns = elapsedNs(benchmark.run, iterations);
+	while (ns < minNs && iterations < (1ull << 40)) {
+		const double scale = ns > 0.0 ? std::clamp(1.2 * minNs / ns, 2.0, 100.0) : 100.0;
+		iterations = static_cast<uint64_t>(iterations * scale);
+		ns = elapsedNs(benchmark.run, iterations);
+	}
+
+	for (uint32_t ix = 0; ix < settings.warmupRepetitions; ++ix)
+		elapsedNs(benchmark.run, iterations);
+
+	std::vector<double> perItem(settings.repetitions);
+	for (double& val : perItem)
+		val = elapsedNs(benchmark.run, iterations) / (static_cast<double>(iterations) * benchmark.itemsPerIteration);
+	std::sort(perItem.begin(), perItem.end());
+
+	Result result{ benchmark.name, iterations };
+	result.minNs = perItem.front();
+	result.maxNs = perItem.back();
+	const size_t mid = perItem.size() / 2;
+	result.medianNs = perItem.size() % 2 == 1 ? perItem[mid] : (perItem[mid - 1] + perItem[mid]) / 2.0;
+	for (double val : perItem)
+		result.meanNs += val / perItem.size();
+	double sumSq = 0.0;
+	for (double val : perItem)
+		sumSq += (val - result.meanNs) * (val - result.meanNs);
+	result.stdDevNs = perItem.size() > 1 ? std::sqrt(sumSq / (perItem.size() - 1)) : 0.0;
+	return result;
+}
+
+int Runner::runAll() const {
+	const auto baseline = settings.baselinePath.empty() ? std::unordered_map<std::string, double>{} : readBaseline(settings.baselinePath);
+
+	std::vector<Result> results;
+	int regressions = 0;
+	std::printf("%-48s %14s %12s %12s %10s\n", "benchmark", "iterations", "median ns", "min ns", "stddev %");
+	for (const Benchmark& benchmark : benchmarks) {
+		if (!settings.filter.empty() && benchmark.name.find(settings.filter) == std::string::npos)
+			continue;
+		const Result r = measure(benchmark);
+		results.push_back(r);
+		std::printf("%-48s %14llu %12.2f %12.2f %9.1f%%", r.name.c_str(), static_cast<unsigned long long>(r.iterations), r.medianNs, r.minNs, 100.0 * r.stdDevNs / r.meanNs);
+
+		const auto it = baseline.find(r.name);
+		if (it != baseline.end() && it->second > 0.0) {
+			const double change = r.medianNs / it->second - 1.0;
+			const bool isRegression = change > settings.regressionThreshold;
+			regressions += isRegression ? 1 : 0;
+			std::printf("  %+6.1f%% vs baseline%s", 100.0 * change, isRegression ? "  REGRESSION" : "");
+		}
+		std::printf("\n");
+		std::fflush(stdout);
+	}
+
+	if (!settings.jsonPath.empty())
+		writeJson(settings.jsonPath, settings, results);
+	return regressions;
+}
+
+int Runner::runChecks() const {
+	int mismatches = 0;
+	size_t count = 0;
+	for (const Check& check : checks) {
+		if (!settings.filter.empty() && check.name.find(settings.filter) == std::string::npos)
+			continue;
+		mismatches += check.run();
+		++count;
+		std::fflush(stdout);
+	}
+	std::printf("%zu checks, %d mismatches\n", count, mismatches);
+	return mismatches;
+}
+
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+// Keeps the compiler from optimizing away a value computed by a benchmark
+template<typename T>
+inline void doNotOptimize(const T& value) {
+#if defined(_MSC_VER)
+	static const volatile void* sink;
+	sink = &value;
+#else
+	asm volatile("" : : "r,m"(value) : "memory");
+#endif
+}
+
+struct Settings {
+	// substring that benchmark names have to contain, empty for all
+	std::string filter;
+	uint32_t repetitions = 10;
+	// iterations per repetition are calibrated so that a repetition takes at least this long
+	double minRepetitionMs = 20.0;
+	// discarded repetitions before measuring, after calibration
+	uint32_t warmupRepetitions = 1;
+	std::string jsonPath;
+	// previous JSON output to compare medians against
+	std::string baselinePath;
+	// relative slow down of the median that is reported as a regression
+	double regressionThreshold = 0.10;
+	// run the checks instead of the benchmarks
+	bool isVerifying = false;
+
+	// --filter s --repetitions n --min-time-ms t --json path --baseline path --verify
+	static Settings fromArgs(int argc, char* args[]);
+};
+
+struct Benchmark {
+	std::string name;
+	// runs the measured operation `iterations` times
+	std::function<void(uint64_t iterations)> run;
+	// items processed by one iteration, timings are reported per item
+	uint64_t itemsPerIteration = 1;
+};
+
+struct Check {
+	std::string name;
+	// returns the number of mismatches, the details go to stdout
+	std::function<int()> run;
+};
+
+struct Result {
+	std::string name;
+	uint64_t iterations{}; // per repetition
+	// per item, over repetitions
+	double minNs{};
+	double medianNs{};
+	double meanNs{};
+	double stdDevNs{};
+	double maxNs{};
+};
+
+class Runner {
+private:
+	Settings settings;
+	std::vector<Benchmark> benchmarks;
+	std::vector<Check> checks;
+private:
+	Result measure(const Benchmark& benchmark) const;
+public:
+	Runner(const Settings& settings);
+
+	void add(const std::string& name, std::function<void(uint64_t iterations)> run, uint64_t itemsPerIteration = 1);
+	void addCheck(const std::string& name, std::function<int()> run);
+	// returns the number of regressions against the baseline
+	int runAll() const;
+	// runs the checks whose names contain the filter, returns the number of mismatches
+	int runChecks() const;
+};
+
+}
@@ -0,0 +1,132 @@
+#include "Bench.h"
+#include "Policies.h"
+
+#include <PackedBody.h>
+#include <RingBuffer.h>
+#include <Rng.h>
+#include <Snake.h>
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+// head to tail, true if the packed body decodes to the same cells both ways
+bool isSame(const Snake& snake, const PackedBody& body) {
+	if (body.size() != snake.getCells().size() || !body.getHead().isSameAs(snake.getHead()) || !body.getTail().isSameAs(snake.getTail()))
+		return false;
+	size_t ix = 0;
+	bool isEqual = true;
+	body.forEachCell([&](const Cell& cell) {
+		isEqual = isEqual && cell.isSameAs(snake.getCells()[ix++]);
+	});
+	ix = 0;
+	for (const Cell& cell : body)
+		isEqual = isEqual && cell.isSameAs(snake.getCells()[ix++]);
+	return isEqual && ix == snake.getCells().size();
+}
+
+// cells from head to tail of a snake of the given length that followed the Hamiltonian cycle from (0, 0)
+gds::RingBuffer<Cell> cycleBody(uint32_t length, int32_t gridSize) {
+	std::vector<Cell> path{ Cell{ 0, 0 } };
+	while (path.size() < length)
+		path.push_back(path.back().addCell(Cell::deltaCell(bench::cycleDirection(path.back(), gridSize))));
+	gds::RingBuffer<Cell> cells{ length };
+	for (const Cell& cell : path)
+		cells.pushFront(cell);
+	return cells;
+}
+
+}
+
+// Plays a snake that grows at random times and mirrors every move in a PackedBody, which starts small so that it grows.
+// Compares the decoded cells with the snake's. Returns the number of mismatches.
+int verifyPackedBody() {
+	int mismatches = 0;
+	constexpr int32_t GRID_SIZE = 64;
+	const Cell start[] = { Cell{ 1, 0 }, Cell{ 0, 0 } };
+	Snake snake{ start, Direction::RIGHT, GRID_SIZE };
+	PackedBody body{ snake.getCells(), 2 };
+	Rng rng{ 21 };
+	uint64_t ticks = 0;
+	for (; ticks < 200000; ++ticks) {
+		// along the Hamiltonian cycle, which turns in every direction and never runs into the body
+		const sim::Action action = bench::actionToward(snake.getDirection(), bench::cycleDirection(snake.getHead(), GRID_SIZE));
+		if (action == sim::Action::TURN_LEFT)
+			snake.turnLeft();
+		else if (action == sim::Action::TURN_RIGHT)
+			snake.turnRight();
+
+		// grows now and then up to a third of the grid, the ring wraps around many times on the way
+		if (snake.getCells().size() < GRID_SIZE * GRID_SIZE / 3 && rng.nextBelow(8) == 0) {
+			snake.elongate();
+			body.pushHead(snake.getDirection());
+		} else {
+			snake.move();
+			body.pushHead(snake.getDirection());
+			body.popTail();
+		}
+		if (ticks % 101 == 0 && !isSame(snake, body) && mismatches++ < 10)
+			std::printf("PackedBody mismatch at tick %llu\n", static_cast<unsigned long long>(ticks));
+	}
+	mismatches += isSame(snake, body) ? 0 : 1;
+
+	// rebuilt from the cells, then taken apart from both ends
+	PackedBody rebuilt{ snake.getCells() };
+	mismatches += isSame(snake, rebuilt) ? 0 : 1;
+	Snake shorter = snake;
+	while (shorter.getCells().size() > 2) {
+		shorter.retractHead();
+		rebuilt.popHead();
+	}
+	mismatches += isSame(shorter, rebuilt) ? 0 : 1;
+
+	std::printf("PackedBody: %llu ticks, length %zu, %zu bytes instead of %zu, %d mismatches\n", static_cast<unsigned long long>(ticks),
+		body.size(), body.getMemoryBytes(), snake.getCells().capacity() * sizeof(Cell), mismatches);
+	return mismatches;
+}
+
+// Walking the whole body from head to tail, timing is per cell.
+void registerPackedBodyBenchmarks(bench::Runner& runner) {
+	for (uint32_t length : { 1000u, 100000u, 4000000u }) {
+		const std::string suffix = "/" + std::to_string(length);
+		const int32_t gridSize = 4096;
+		auto cells = std::make_shared<const gds::RingBuffer<Cell>>(cycleBody(length, gridSize));
+		auto body = std::make_shared<const PackedBody>(*cells);
+		std::printf("Snake body of %u cells: RingBuffer<Cell> %zu bytes, PackedBody %zu bytes\n", length, cells->capacity() * sizeof(Cell), body->getMemoryBytes());
+
+		runner.add("RingBuffer<Cell>/iterate" + suffix, [cells](uint64_t iterations) {
+			int64_t sum = 0;
+			for (uint64_t ix = 0; ix < iterations; ++ix)
+				for (const Cell& cell : *cells)
+					sum += cell.x + cell.y;
+			bench::doNotOptimize(sum);
+		}, length);
+
+		runner.add("PackedBody::forEachCell" + suffix, [body](uint64_t iterations) {
+			int64_t sum = 0;
+			for (uint64_t ix = 0; ix < iterations; ++ix)
+				body->forEachCell([&sum](const Cell& cell) { sum += cell.x + cell.y; });
+			bench::doNotOptimize(sum);
+		}, length);
+
+		runner.add("PackedBody::Iterator" + suffix, [body](uint64_t iterations) {
+			int64_t sum = 0;
+			for (uint64_t ix = 0; ix < iterations; ++ix)
+				for (const Cell& cell : *body)
+					sum += cell.x + cell.y;
+			bench::doNotOptimize(sum);
+		}, length);
+	}
+
+	// a tick of a long snake: push a head, pop the tail
+	runner.add("PackedBody::pushHead+popTail", [body = std::make_shared<PackedBody>(cycleBody(100000, 4096))](uint64_t iterations) {
+		for (uint64_t ix = 0; ix < iterations; ++ix) {
+			body->pushHead(static_cast<Direction>(ix & 1));
+			body->popTail();
+		}
+		bench::doNotOptimize(body->getHead());
+	});
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <Cell.h>
+#include <HamiltonianCycle.h>
+#include <Simulation.h>
+
+#include <cstdint>
+
+// Simple steering for benchmarks and checks, no planning.
+namespace bench {
+
+// direction along the sim::HamiltonianCycle of the grid
+inline Direction cycleDirection(const Cell& cell, int32_t gridSize) {
+	return sim::HamiltonianCycle{ gridSize }.getDirection(cell);
+}
+
+// turn that heads towards desired, none when it is ahead or behind
+inline sim::Action actionToward(Direction current, Direction desired) {
+	const int diff = (static_cast<int>(desired) - static_cast<int>(current) + 4) % 4;
+	return diff == 1 ? sim::Action::TURN_LEFT : diff == 3 ? sim::Action::TURN_RIGHT : sim::Action::NONE;
+}
+
+}
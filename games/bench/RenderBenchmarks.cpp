@@ -0,0 +1,79 @@
+#include "Bench.h"
+
+#include <gds.h>
+#include <Widgets.h>
+
+#include <SDL.h>
+
+#include <string>
+
+namespace {
+
+const SDL_Color COLOR{ 0xCC, 0x22, 0x33, 0xFF };
+
+// executes queued draw commands, so that their cost lands in the iteration that issued them
+void flush() {
+	SDL_RenderFlush(gds::sdl.renderer);
+}
+
+}
+
+void registerRenderBenchmarks(bench::Runner& runner) {
+	runner.add("gds::renderText", [](uint64_t iterations) {
+		gds::Font& font = gds::sdl.getFont(gds::DEFAULT_FONT);
+		for (uint64_t ix = 0; ix < iterations; ++ix) {
+			gds::renderText("score: 1234", COLOR, 0, 0, font);
+			flush();
+		}
+	});
+
+	// what renderText used to do every call: rasterize, upload, draw, destroy
+	runner.add("TextTexture::setText+render", [](uint64_t iterations) {
+		static gds::TextTexture text{ "score: 1234", gds::sdl.getFont(gds::DEFAULT_FONT), COLOR };
+		for (uint64_t ix = 0; ix < iterations; ++ix) {
+			text.setText("score: 1234");
+			text.render({ 0, 0 });
+			flush();
+		}
+	});
+
+	runner.add("TextTexture::render", [](uint64_t iterations) {
+		static gds::TextTexture text{ "score: 1234", gds::sdl.getFont(gds::DEFAULT_FONT), COLOR };
+		for (uint64_t ix = 0; ix < iterations; ++ix) {
+			text.render({ 0, 0 });
+			flush();
+		}
+	});
+
+	runner.add("MenuPage::render", [](uint64_t iterations) {
+		static gds::MenuPage page = [] {
+			gds::MenuPage p{ { 350, 400 } };
+			for (const char* label : { "Start", "Settings", "Help", "Exit" })
+				p.addButton(label);
+			return p;
+		}();
+		for (uint64_t ix = 0; ix < iterations; ++ix) {
+			page.render();
+			flush();
+		}
+	});
+
+	runner.add("Texture/create+destroy", [](uint64_t iterations) {
+		for (uint64_t ix = 0; ix < iterations; ++ix) {
+			gds::TargetTexture tex{ 64, 64 };
+			bench::doNotOptimize(tex.get());
+		}
+	});
+
+	// three move assignments per iteration, a swap
+	runner.add("Texture/move", [](uint64_t iterations) {
+		static gds::TargetTexture a{ 64, 64 };
+		static gds::TargetTexture b{ 64, 64 };
+		for (uint64_t ix = 0; ix < iterations; ++ix) {
+			gds::TargetTexture tmp = std::move(a);
+			a = std::move(b);
+			b = std::move(tmp);
+		}
+		bench::doNotOptimize(a.get());
+	});
+}
@@ -0,0 +1,151 @@
+#include "Bench.h"
+#include "Policies.h"
+
+#include <Replay.h>
+#include <Rng.h>
+#include <Simulation.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Checkpoint {
+	uint64_t tick{};
+	Cell head;
+	size_t length{};
+	uint32_t score{};
+};
+
+// Plays a game into a replay file: along the Hamiltonian cycle (a long game that fills the grid), or turning at random
+// until it dies. Returns a checkpoint every few ticks, the last one is the end of the game.
+std::vector<Checkpoint> recordGame(const std::string& path, int32_t gridSize, bool isCycling, uint64_t seed) {
+	sim::State state{ gridSize, Rng{ seed } };
+	sim::ReplayWriter writer;
+	writer.begin(path, state, 200, 64);
+	Rng rng{ seed + 1 };
+	std::vector<Checkpoint> checkpoints;
+	while (true) {
+		if (state.ticks % 37 == 0)
+			checkpoints.push_back({ state.ticks, state.snake.getHead(), state.snake.getCells().size(), state.score });
+		sim::Action action = bench::actionToward(state.snake.getDirection(), bench::cycleDirection(state.snake.getHead(), gridSize));
+		if (!isCycling) {
+			const uint32_t roll = rng.nextBelow(8);
+			action = roll == 0 ? sim::Action::TURN_LEFT : roll == 1 ? sim::Action::TURN_RIGHT : sim::Action::NONE;
+		}
+		writer.recordStep(state, action);
+		const sim::Outcome outcome = sim::step(state, action);
+		if (outcome == sim::Outcome::ATE_APPLE)
+			writer.recordApple(state);
+		if (sim::isGameOver(outcome) || !state.hasApple)
+			break;
+	}
+	checkpoints.push_back({ state.ticks, state.snake.getHead(), state.snake.getCells().size(), state.score });
+	writer.end(state);
+	return checkpoints;
+}
+
+bool matches(const sim::State& state, const Checkpoint& checkpoint) {
+	return state.ticks == checkpoint.tick && state.snake.getHead().isSameAs(checkpoint.head)
+		&& state.snake.getCells().size() == checkpoint.length && state.score == checkpoint.score;
+}
+
+std::string replayPath(const char* name) {
+	return (std::filesystem::temp_directory_path() / name).string();
+}
+
+}
+
+// Records games, plays them back through a mapped file and compares the states: fast-forward, keyframes and seeks
+// in both directions. A replay with a broken keyframe has to be rejected. Returns the number of mismatches.
+int verifyReplay() {
+	int mismatches = 0;
+	for (const bool isCycling : { true, false }) {
+		const std::string path = replayPath(isCycling ? "gds_verify_cycle.gdsr" : "gds_verify_random.gdsr");
+		const std::vector<Checkpoint> checkpoints = recordGame(path, 16, isCycling, 3);
+
+		sim::MappedFile file;
+		sim::Replay replay;
+		if (!file.open(path) || !replay.open(file.getBytes())) {
+			++mismatches;
+			continue;
+		}
+		sim::ReplayPlayer player{ replay };
+		player.fastForward();
+		mismatches += matches(player.getState(), checkpoints.back()) ? 0 : 1;
+		mismatches += static_cast<int>(player.getKeyframeMismatches());
+
+		// backwards from the end, then forwards in big jumps
+		for (auto checkpoint = checkpoints.rbegin(); checkpoint != checkpoints.rend(); ++checkpoint) {
+			player.seek(checkpoint->tick);
+			mismatches += matches(player.getState(), *checkpoint) ? 0 : 1;
+		}
+		for (size_t ix = 0; ix < checkpoints.size(); ix += 7) {
+			player.seek(checkpoints[ix].tick);
+			mismatches += matches(player.getState(), checkpoints[ix]) ? 0 : 1;
+		}
+		// a copy with a cell of the last keyframe outside the grid, then with the head twice, does not open
+		if (!replay.getKeyframes().empty()) {
+			std::vector<uint8_t> broken{ file.getBytes().begin(), file.getBytes().end() };
+			size_t cells = static_cast<size_t>(replay.getKeyframes().back().offset);
+			while ((broken[cells++] & 0x80) != 0) {
+			}
+			cells += sizeof(sim::ReplayKeyframe);
+			const uint16_t outside = static_cast<uint16_t>(replay.getHeader().gridSize);
+			std::memcpy(broken.data() + cells, &outside, sizeof(outside));
+			sim::Replay brokenReplay;
+			mismatches += brokenReplay.open(broken) ? 1 : 0;
+			std::memcpy(broken.data() + cells, file.getBytes().data() + cells, 4);
+			std::memcpy(broken.data() + cells + 4, broken.data() + cells, 4);
+			mismatches += brokenReplay.open(broken) ? 1 : 0;
+		}
+		// a copy whose footer claims more keyframes than the file holds opens from its records
+		{
+			std::vector<uint8_t> inflated{ file.getBytes().begin(), file.getBytes().end() };
+			const uint32_t keyframeCount = UINT32_MAX;
+			std::memcpy(inflated.data() + inflated.size() - sizeof(sim::ReplayFooter) + offsetof(sim::ReplayFooter, keyframeCount),
+				&keyframeCount, sizeof(keyframeCount));
+			sim::Replay inflatedReplay;
+			mismatches += inflatedReplay.open(inflated) && inflatedReplay.getKeyframes().size() == replay.getKeyframes().size() ? 0 : 1;
+		}
+		std::printf("Replay %s: %llu ticks, %zu bytes, %zu keyframes, %d mismatches so far\n", isCycling ? "cycle" : "random",
+			static_cast<unsigned long long>(replay.getEndTick()), file.getBytes().size(), replay.getKeyframes().size(), mismatches);
+		file.close();
+		std::error_code error;
+		std::filesystem::remove(path, error);
+	}
+	return mismatches;
+}
+
+// Timing per replayed tick for fast-forward, per seek for seeking.
+void registerReplayBenchmarks(bench::Runner& runner) {
+	const std::string path = replayPath("gds_bench_cycle.gdsr");
+	recordGame(path, 20, true, 5);
+	auto file = std::make_shared<sim::MappedFile>();
+	auto replay = std::make_shared<sim::Replay>();
+	if (!file->open(path) || !replay->open(file->getBytes()))
+		return;
+	const uint64_t ticks = replay->getEndTick();
+
+	runner.add("ReplayPlayer::fastForward/20", [file, replay](uint64_t iterations) {
+		for (uint64_t ix = 0; ix < iterations; ++ix) {
+			sim::ReplayPlayer player{ *replay };
+			bench::doNotOptimize(player.fastForward());
+		}
+	}, ticks);
+
+	auto player = std::make_shared<sim::ReplayPlayer>(*replay);
+	runner.add("ReplayPlayer::seek/20", [file, replay, player, ticks](uint64_t iterations) {
+		Rng rng{ 9 };
+		for (uint64_t ix = 0; ix < iterations; ++ix) {
+			player->seek(rng.nextBelow(static_cast<uint32_t>(ticks)));
+			bench::doNotOptimize(player->getTick());
+		}
+	});
+}
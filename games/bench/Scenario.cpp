@@ -0,0 +1,208 @@
+#include "Scenario.h"
+
+#include <AllocationTracker.h>
+#include <Game.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <utility>
+
+namespace bench {
+
+namespace {
+
+void pushKey(SDL_Keycode key) {
+	SDL_Event e{};
+	e.type = SDL_KEYDOWN;
+	e.key.timestamp = SDL_GetTicks();
+	e.key.keysym.sym = key;
+	SDL_PushEvent(&e);
+}
+
+// nearest rank percentile of sorted values
+double percentile(const std::vector<double>& sorted, double p) {
+	if (sorted.empty())
+		return 0.0;
+	const size_t rank = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+	return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+// reads `"name": number` from our own JSON output, false if missing
+bool readNumber(const std::string& json, const std::string& name, double& value) {
+	const std::string key = "\"" + name + "\": ";
+	const size_t pos = json.find(key);
+	if (pos == std::string::npos)
+		return false;
+	value = std::stod(json.substr(pos + key.size()));
+	return true;
+}
+
+}
+
+//------------- ScenarioSettings
+
+ScenarioSettings ScenarioSettings::fromArgs(int argc, char* args[]) {
+	ScenarioSettings settings;
+	for (int ix = 1; ix < argc; ++ix) {
+		const std::string arg = args[ix];
+		if (arg == "--assert-no-alloc") {
+			settings.assertNoAllocations = true;
+			continue;
+		}
+		if (ix + 1 == argc)
+			break;
+		const std::string val = args[ix + 1];
+		if (arg == "--frames")
+			settings.frames = std::max(1ll, std::stoll(val));
+		else if (arg == "--seed")
+			settings.seed = static_cast<uint32_t>(std::stoul(val));
+		else if (arg == "--json")
+			settings.jsonPath = val;
+		else if (arg == "--baseline")
+			settings.baselinePath = val;
+		else
+			continue;
+		++ix;
+	}
+	return settings;
+}
+
+//------------- Scenario
+
+Scenario::Scenario(const ScenarioSettings& settings) : settings(settings) {}
+
+void Scenario::setIntro(std::vector<ScriptedKey> keys, uint32_t frames, int32_t gridSize) {
+	intro = std::move(keys);
+	introFrames = frames;
+	introGridSize = gridSize;
+}
+
+void Scenario::setLoop(std::vector<ScriptedKey> keys, uint32_t frames) {
+	loop = std::move(keys);
+	loopFrames = std::max(1u, frames);
+}
+
+ScenarioReport Scenario::run(Game& game) const {
+	ScenarioReport report;
+	game.getStateManager().playingState->seed(settings.seed);
+	gds::allocationTracker.setAssertMode(settings.assertNoAllocations);
+
+	std::vector<double> frameMs;
+	frameMs.reserve(settings.frames);
+	size_t introIx = 0;
+	size_t loopIx = 0;
+	const uint64_t startUpdates = game.getUpdateCount();
+	const StateManager& states = game.getStateManager();
+	const uint64_t startTicks = states.playingState->getTickCount();
+	// a cycle has to play: pass through the playing state and advance the snake
+	bool isCyclePlaying = false;
+	uint64_t cycleStartTicks = startTicks;
+	const gds::InputQueue& input = game.getStateManager().playingState->getInput();
+	const uint64_t startDropped = input.getDroppedCount();
+	const gds::AllocationStats startAllocations = gds::allocationTracker.getTotal();
+	const auto start = std::chrono::steady_clock::now();
+
+	for (uint64_t frame = 0; frame < settings.frames && !game.isQuitting(); ++frame) {
+		// keys due this frame go through SDL's queue, exactly like real input
+		if (frame < introFrames) {
+			for (; introIx < intro.size() && intro[introIx].frame == frame; ++introIx)
+				pushKey(intro[introIx].key);
+		}
+		else {
+			if (frame == introFrames && game.getStateManager().playingState->gridSize != introGridSize)
+				++report.desyncs;
+			const uint32_t loopFrame = static_cast<uint32_t>((frame - introFrames) % loopFrames);
+			if (loopFrame == 0) {
+				if (frame > introFrames) {
+					++report.cycles;
+					const uint64_t ticks = states.playingState->getTickCount();
+					if (game.getState() != states.menuState.get() || !isCyclePlaying || ticks == cycleStartTicks)
+						++report.desyncs;
+					cycleStartTicks = ticks;
+				}
+				isCyclePlaying = false;
+				loopIx = 0;
+			}
+			for (; loopIx < loop.size() && loop[loopIx].frame == loopFrame; ++loopIx)
+				pushKey(loop[loopIx].key);
+		}
+
+		const auto frameStart = std::chrono::steady_clock::now();
+		game.runFrame();
+		frameMs.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count());
+		isCyclePlaying = isCyclePlaying || game.getState() == states.playingState.get();
+	}
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	const gds::AllocationStats endAllocations = gds::allocationTracker.getTotal();
+	report.frames = frameMs.size();
+	report.updates = game.getUpdateCount() - startUpdates;
+	report.ticks = game.getStateManager().playingState->getTickCount() - startTicks;
+
+	std::sort(frameMs.begin(), frameMs.end());
+	const double frames = std::max<double>(1.0, static_cast<double>(report.frames));
+	report.metrics = {
+		{ "ticks_per_sec", seconds > 0.0 ? report.ticks / seconds : 0.0, true },
+		{ "updates_per_sec", seconds > 0.0 ? report.updates / seconds : 0.0, true },
+		{ "frame_ms_p50", percentile(frameMs, 0.50) },
+		{ "frame_ms_p90", percentile(frameMs, 0.90) },
+		{ "frame_ms_p99", percentile(frameMs, 0.99) },
+		{ "frame_ms_max", frameMs.empty() ? 0.0 : frameMs.back() },
+		{ "allocations_per_frame", (endAllocations.count - startAllocations.count) / frames },
+		{ "allocated_bytes_per_frame", (endAllocations.bytes - startAllocations.bytes) / frames },
+		// from a key event to the tick that took it, in SDL time: headless frames run faster than real time
+		{ "input_latency_ms_mean", input.getMeanLatencyMs() },
+		{ "input_latency_ms_max", static_cast<double>(input.getMaxLatencyMs()) },
+		{ "input_dropped", static_cast<double>(input.getDroppedCount() - startDropped) },
+	};
+	return report;
+}
+
+int Scenario::report(const ScenarioReport& report) const {
+	std::string baseline;
+	if (!settings.baselinePath.empty()) {
+		std::ifstream in{ settings.baselinePath };
+		if (!in)
+			std::cerr << "Could not open baseline " << settings.baselinePath << "\n";
+		std::stringstream buffer;
+		buffer << in.rdbuf();
+		baseline = buffer.str();
+	}
+
+	int regressions = 0;
+	std::printf("frames %llu, updates %llu, snake ticks %llu, cycles %llu, desyncs %llu\n",
+		static_cast<unsigned long long>(report.frames), static_cast<unsigned long long>(report.updates),
+		static_cast<unsigned long long>(report.ticks), static_cast<unsigned long long>(report.cycles),
+		static_cast<unsigned long long>(report.desyncs));
+	for (const ScenarioMetric& metric : report.metrics) {
+		std::printf("%-24s %14.4f", metric.name.c_str(), metric.value);
+		double previous{};
+		if (!baseline.empty() && readNumber(baseline, metric.name, previous) && previous > 0.0) {
+			const double change = metric.value / previous - 1.0;
+			const bool isRegression = (metric.isHigherBetter ? -change : change) > settings.regressionThreshold;
+			regressions += isRegression ? 1 : 0;
+			std::printf("  %+6.1f%% vs baseline%s", 100.0 * change, isRegression ? "  REGRESSION" : "");
+		}
+		std::printf("\n");
+	}
+
+	if (!settings.jsonPath.empty()) {
+		std::ofstream out{ settings.jsonPath };
+		if (!out)
+			std::cerr << "Could not open " << settings.jsonPath << " to write results\n";
+		out << "{\n  \"seed\": " << settings.seed << ",\n  \"frames\": " << report.frames
+			<< ",\n  \"updates\": " << report.updates << ",\n  \"ticks\": " << report.ticks
+			<< ",\n  \"cycles\": " << report.cycles << ",\n  \"desyncs\": " << report.desyncs
+			<< ",\n  \"metrics\": {";
+		for (size_t ix = 0; ix < report.metrics.size(); ++ix)
+			out << (ix == 0 ? "\n" : ",\n") << "    \"" << report.metrics[ix].name << "\": " << report.metrics[ix].value;
+		out << "\n  }\n}\n";
+	}
+	return regressions + static_cast<int>(report.desyncs);
+}
+
+}
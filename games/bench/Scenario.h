@@ -0,0 +1,77 @@
+#pragma once
+
+#include <SDL.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class Game;
+
+namespace bench {
+
+// key pressed at a frame, counted from the start of its script
+struct ScriptedKey {
+	uint32_t frame;
+	SDL_Keycode key;
+};
+
+struct ScenarioSettings {
+	uint64_t frames = 3600;
+	uint32_t seed = 1;
+	std::string jsonPath;
+	// previous JSON output to compare the metrics against
+	std::string baselinePath;
+	// relative worsening of a metric that is reported as a regression
+	double regressionThreshold = 0.10;
+	// abort when the playing state allocates after warmup
+	bool assertNoAllocations = false;
+
+	// --frames n --seed s --json path --baseline path --assert-no-alloc
+	static ScenarioSettings fromArgs(int argc, char* args[]);
+};
+
+struct ScenarioMetric {
+	std::string name;
+	double value{};
+	// throughputs get better when higher, times and allocations when lower
+	bool isHigherBetter = false;
+};
+
+struct ScenarioReport {
+	uint64_t frames{};
+	uint64_t updates{};
+	uint64_t ticks{};
+	uint64_t cycles{};
+	// an intro that did not select its grid size and cycles that did not play or did not end back in the main menu,
+	// the script lost sync with the game
+	uint64_t desyncs{};
+	std::vector<ScenarioMetric> metrics;
+};
+
+// Drives a Game with scripted key presses for a fixed number of frames and measures whole frames.
+// The intro script runs once, then the loop script repeats. The loop has to start and end in the main menu and play
+// in between: pass through the playing state and advance the snake.
+class Scenario {
+private:
+	ScenarioSettings settings;
+	std::vector<ScriptedKey> intro;
+	std::vector<ScriptedKey> loop;
+	uint32_t introFrames{};
+	int32_t introGridSize{};
+	uint32_t loopFrames{};
+public:
+	Scenario(const ScenarioSettings& settings);
+
+	// keys of each script are sorted by frame, the script lasts `frames` frames.
+	// gridSize is the area size the intro selects, checked when it ends.
+	void setIntro(std::vector<ScriptedKey> keys, uint32_t frames, int32_t gridSize);
+	void setLoop(std::vector<ScriptedKey> keys, uint32_t frames);
+
+	ScenarioReport run(Game& game) const;
+	// prints the report, compares it with the baseline and writes the JSON output if requested.
+	// Returns the number of regressions plus desyncs.
+	int report(const ScenarioReport& report) const;
+};
+
+}
@@ -0,0 +1,44 @@
+#include "Scenario.h"
+
+#include <Game.h>
+#include <gds.h>
+
+const int SIZE = 800;
+
+// Headless unless GDS_HEADLESS=0, the scenario runs at full speed on virtual time
+gds::Sdl gds::sdl = gds::Sdl("gds_scenario", SIZE, SIZE, gds::SdlSettings::fromEnvironment({ .headless = true }));
+
+// Usage: gds_scenario [--frames n] [--seed s] [--json out.json] [--baseline previous.json] [--assert-no-alloc]
+// Exits with 1 if a metric regressed against the baseline or the script lost sync with the game.
+int main(int argc, char* args[]) {
+	gds::sdl.loadFont(gds::DEFAULT_FONT, "assets/fonts/enter_command/EnterCommand.ttf", 28);
+	gds::sdl.loadFont(gds::TITLE_FONT, "assets/fonts/enter_command/EnterCommand.ttf", 40);
+
+	bench::Scenario scenario{ bench::ScenarioSettings::fromArgs(argc, args) };
+
+	// Once: main menu -> settings, cycle the area size Large, Huge, Small and back to Medium (20x20), leave the mode
+	// on Classic, set speed to Fast, back, select Start
+	scenario.setIntro({
+		{ 0, SDLK_DOWN }, { 5, SDLK_RETURN },
+		{ 10, SDLK_RETURN }, { 15, SDLK_RETURN }, { 20, SDLK_RETURN }, { 25, SDLK_RETURN },
+		{ 30, SDLK_DOWN },
+		{ 35, SDLK_DOWN }, { 40, SDLK_RETURN },
+		{ 45, SDLK_DOWN }, { 50, SDLK_RETURN },
+		{ 55, SDLK_UP },
+	}, 60, 20);
+
+	// Repeated at 60 fps and a 100 ms period (6 frames per tick) on a 20x20 grid:
+	// start, turn, pause, move in the pause menu, resume, turn, run into a wall, back to the main menu
+	scenario.setLoop({
+		{ 0, SDLK_RETURN },
+		{ 20, SDLK_LEFT },
+		{ 35, SDLK_ESCAPE },
+		{ 60, SDLK_DOWN }, { 65, SDLK_UP }, { 80, SDLK_RETURN },
+		{ 100, SDLK_RIGHT },
+		{ 240, SDLK_RETURN },
+	}, 260);
+
+	Game game{ gds::LoopSettings{} };
+	const bench::ScenarioReport report = scenario.run(game);
+	return scenario.report(report) == 0 ? 0 : 1;
+}
@@ -0,0 +1,208 @@
+#include "Bench.h"
+#include "Policies.h"
+
+#include <AllocationTracker.h>
+#include <BoardTexture.h>
+#include <Camera.h>
+#include <GameStates.h>
+#include <gds.h>
+#include <Simulation.h>
+#include <Snake.h>
+
+#include <SDL.h>
+
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using bench::cycleDirection;
+using bench::actionToward;
+
+void steer(Snake& snake, Direction desired) {
+	const int diff = (static_cast<int>(desired) - static_cast<int>(snake.getDirection()) + 4) % 4;
+	if (diff == 1)
+		snake.turnLeft();
+	else if (diff == 3)
+		snake.turnRight();
+}
+
+// smallest even grid side with room for the snake
+int32_t gridSizeFor(uint32_t length) {
+	int32_t gridSize = 4;
+	while (static_cast<uint64_t>(gridSize) * gridSize < 2ull * length)
+		gridSize += 2;
+	return gridSize;
+}
+
+Snake makeSnake(uint32_t length, int32_t gridSize) {
+	Snake snake{ Cell{ 0, 0 }, 1, Direction::RIGHT, gridSize };
+	while (snake.getCells().size() < length) {
+		steer(snake, cycleDirection(snake.getHead(), gridSize));
+		snake.elongate();
+	}
+	return snake;
+}
+
+}
+
+void registerSnakeBenchmarks(bench::Runner& runner, StateManager& stateManager) {
+	for (uint32_t length : { 10u, 1000u, 100000u }) {
+		const std::string suffix = "/" + std::to_string(length);
+		const int32_t gridSize = gridSizeFor(length);
+
+		runner.add("Snake::move" + suffix, [gridSize, snake = std::make_shared<Snake>(makeSnake(length, gridSize))](uint64_t iterations) {
+			for (uint64_t ix = 0; ix < iterations; ++ix) {
+				steer(*snake, cycleDirection(snake->getHead(), gridSize));
+				snake->move();
+			}
+			bench::doNotOptimize(snake->getHead());
+		});
+
+		// grows a fresh snake to the length, timing is per elongate
+		runner.add("Snake::elongate" + suffix, [length, gridSize](uint64_t iterations) {
+			for (uint64_t ix = 0; ix < iterations; ++ix) {
+				Snake snake = makeSnake(length, gridSize);
+				bench::doNotOptimize(snake.getHead());
+			}
+		}, length);
+
+		auto queries = std::make_shared<std::vector<Cell>>(4096);
+		std::mt19937 rnd{ 42 };
+		std::uniform_int_distribution<int32_t> dist{ 0, gridSize - 1 };
+		for (Cell& cell : *queries)
+			cell = { dist(rnd), dist(rnd) };
+		runner.add("Snake::hasCell" + suffix, [queries, snake = std::make_shared<const Snake>(makeSnake(length, gridSize))](uint64_t iterations) {
+			uint32_t hits = 0;
+			for (uint64_t ix = 0; ix < iterations; ++ix)
+				hits += snake->hasCell((*queries)[ix % queries->size()]) ? 1 : 0;
+			bench::doNotOptimize(hits);
+		});
+	}
+
+	for (int32_t gridSize : { 10, 20, 40, 1000 }) {
+		runner.add("PlayingState::placeApple/" + std::to_string(gridSize), [&stateManager, gridSize](uint64_t iterations) {
+			PlayingState& playing = *stateManager.playingState;
+			if (playing.gridSize != gridSize) {
+				playing.gridSize = gridSize;
+				playing.restart();
+			}
+			for (uint64_t ix = 0; ix < iterations; ++ix)
+				playing.placeApple();
+		});
+	}
+
+	// whole games without SDL: the snake follows the Hamiltonian cycle, eats every apple on its way
+	// and starts over once the grid is full. Timing is per tick.
+	for (int32_t gridSize : { 20, 40, 10000 }) {
+		runner.add("sim::step/" + std::to_string(gridSize), [gridSize](uint64_t iterations) {
+			sim::State state{ gridSize, Rng{ 42 } };
+			for (uint64_t ix = 0; ix < iterations; ++ix) {
+				const Snake& snake = state.snake;
+				const sim::Outcome outcome = sim::step(state, actionToward(snake.getDirection(), cycleDirection(snake.getHead(), gridSize)));
+				if (sim::isGameOver(outcome) || !state.hasApple)
+					state = sim::State{ gridSize, state.rng };
+			}
+			bench::doNotOptimize(state.score);
+		});
+	}
+
+	// A new game per iteration. Memory has to follow the snake rather than the area, the bytes one construction
+	// allocates are printed at registration.
+	for (int32_t gridSize : { 40, 1000, 10000 }) {
+		const uint64_t before = gds::allocationTracker.getTotal().bytes;
+		{
+			sim::State state{ gridSize, Rng{ 42 } };
+			bench::doNotOptimize(state.score);
+		}
+		std::printf("sim::State/%d allocates %llu bytes\n", gridSize, static_cast<unsigned long long>(gds::allocationTracker.getTotal().bytes - before));
+		runner.add("sim::State/" + std::to_string(gridSize), [gridSize](uint64_t iterations) {
+			for (uint64_t ix = 0; ix < iterations; ++ix) {
+				sim::State state{ gridSize, Rng{ 42 } };
+				bench::doNotOptimize(state.score);
+			}
+		});
+	}
+
+	// the snake cells on a screen of a huge grid: the occupancy grid scanned over the view, against walking the body
+	{
+		constexpr uint32_t LENGTH = 100000;
+		const int32_t gridSize = gridSizeFor(LENGTH);
+		auto snake = std::make_shared<const Snake>(makeSnake(LENGTH, gridSize));
+		// the rows below the middle are full of snake
+		const CellRect view{ gridSize / 2, gridSize / 4, 41, 41 };
+		runner.add("OccupancyGrid::forEachSnakeCell/41x41", [snake, view](uint64_t iterations) {
+			uint32_t visible = 0;
+			for (uint64_t ix = 0; ix < iterations; ++ix)
+				snake->getGrid().forEachSnakeCell(view, [&visible](const Cell&) { ++visible; });
+			bench::doNotOptimize(visible);
+		});
+		runner.add("Snake::getCells+cull/41x41", [snake, view](uint64_t iterations) {
+			uint32_t visible = 0;
+			for (uint64_t ix = 0; ix < iterations; ++ix)
+				for (const Cell& cell : snake->getCells())
+					visible += cell.x >= view.x && cell.x < view.x + view.width && cell.y >= view.y && cell.y < view.y + view.height ? 1 : 0;
+			bench::doNotOptimize(visible);
+		});
+	}
+
+	// a frame of a new game, the cost should not grow with the grid
+	for (int32_t gridSize : { 20, 40, 1000, 10000 }) {
+		runner.add("PlayingState::render/" + std::to_string(gridSize), [&stateManager, gridSize](uint64_t iterations) {
+			PlayingState& playing = *stateManager.playingState;
+			if (playing.gridSize != gridSize) {
+				playing.gridSize = gridSize;
+				playing.restart();
+			}
+			for (uint64_t ix = 0; ix < iterations; ++ix) {
+				playing.render(0.5f);
+				SDL_RenderFlush(gds::sdl.renderer);
+			}
+		});
+	}
+
+	// Dense boards, half of the grid is snake. A frame with a tick before it, the board drawn as a streaming texture
+	// against a rect per visible snake cell.
+	for (int32_t gridSize : { 40, 400 }) {
+		auto state = std::make_shared<sim::State>(gridSize, Rng{ 42 });
+		state->snake = makeSnake(static_cast<uint32_t>(gridSize) * gridSize / 2, gridSize);
+		sim::placeApple(*state);
+		const std::string suffix = "/" + std::to_string(gridSize);
+
+		runner.add("BoardTexture::update+render" + suffix, [state, gridSize](uint64_t iterations) {
+			sim::State game = *state;
+			BoardTexture board;
+			board.reserve(gridSize);
+			Camera camera{ gridSize, 800, 40 };
+			for (uint64_t ix = 0; ix < iterations; ++ix) {
+				if (sim::isGameOver(sim::step(game, actionToward(game.snake.getDirection(), cycleDirection(game.snake.getHead(), gridSize)))) || !game.hasApple)
+					game = *state;
+				camera.follow(static_cast<float>(game.snake.getHead().x), static_cast<float>(game.snake.getHead().y));
+				board.update(game);
+				board.render(camera);
+				SDL_RenderFlush(gds::sdl.renderer);
+			}
+		});
+
+		runner.add("PrimitiveBatch/visible cells" + suffix, [state, gridSize](uint64_t iterations) {
+			sim::State game = *state;
+			gds::PrimitiveBatch batch;
+			Camera camera{ gridSize, 800, 40 };
+			batch.reserve(static_cast<size_t>(camera.getMaxVisibleCells()) * camera.getMaxVisibleCells());
+			for (uint64_t ix = 0; ix < iterations; ++ix) {
+				if (sim::isGameOver(sim::step(game, actionToward(game.snake.getDirection(), cycleDirection(game.snake.getHead(), gridSize)))) || !game.hasApple)
+					game = *state;
+				camera.follow(static_cast<float>(game.snake.getHead().x), static_cast<float>(game.snake.getHead().y));
+				const float side = camera.getCellPixels();
+				game.snake.getGrid().forEachSnakeCell(camera.getVisibleCells(), [&](const Cell& cell) {
+					batch.addRect({ camera.toScreenX(static_cast<float>(cell.x)), camera.toScreenY(static_cast<float>(cell.y)), side, side }, { 0x00, 0x00, 0x00, 0xFF });
+				});
+				batch.flush();
+				SDL_RenderFlush(gds::sdl.renderer);
+			}
+		});
+	}
+}
@@ -0,0 +1,144 @@
+#include "Bench.h"
+#include "Policies.h"
+
+#include <Rng.h>
+#include <Simulation.h>
+#include <Snapshot.h>
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+// along the Hamiltonian cycle, a long game that fills the grid
+sim::Action cycleAction(const sim::State& state) {
+	const int32_t gridSize = state.snake.getGrid().getGridSize();
+	return bench::actionToward(state.snake.getDirection(), bench::cycleDirection(state.snake.getHead(), gridSize));
+}
+
+bool isSame(const sim::State& a, const sim::State& b) {
+	if (a.ticks != b.ticks || a.score != b.score || a.hasApple != b.hasApple || !a.apple.isSameAs(b.apple)
+		|| a.rng.getState() != b.rng.getState() || a.snake.getDirection() != b.snake.getDirection()
+		|| a.snake.getCells().size() != b.snake.getCells().size() || a.snake.getGrid().getFreeCount() != b.snake.getGrid().getFreeCount())
+		return false;
+	for (size_t ix = 0; ix < a.snake.getCells().size(); ++ix)
+		if (!a.snake.getCells()[ix].isSameAs(b.snake.getCells()[ix]))
+			return false;
+	return true;
+}
+
+// state after `ticks` steps along the cycle, or once the grid is full
+sim::State playCycle(int32_t gridSize, uint64_t ticks) {
+	sim::State state{ gridSize, Rng{ 11 } };
+	while (state.ticks < ticks && state.hasApple)
+		sim::step(state, cycleAction(state));
+	return state;
+}
+
+}
+
+// Saves and loads snapshots and rewinds games tick by tick, comparing with the states they came from.
+// Returns the number of mismatches.
+int verifySnapshots() {
+	int mismatches = 0;
+	constexpr int32_t GRID_SIZE = 16;
+
+	// round trip, into the same and into a differently sized state
+	const sim::State saved = playCycle(GRID_SIZE, 5000);
+	std::vector<uint8_t> buffer(sim::getMaxSnapshotSize(GRID_SIZE));
+	const size_t size = sim::saveSnapshot(saved, 42, buffer);
+	sim::State loaded = playCycle(GRID_SIZE, 100);
+	sim::State resized{ 8, Rng{ 1 } };
+	uint32_t timer{};
+	mismatches += sim::loadSnapshot({ buffer.data(), size }, loaded, timer) && isSame(saved, loaded) && timer == 42 ? 0 : 1;
+	mismatches += sim::loadSnapshot({ buffer.data(), size }, resized, timer) && isSame(saved, resized) ? 0 : 1;
+	mismatches += sim::loadSnapshot({ buffer.data(), size - 1 }, loaded, timer) ? 1 : 0;
+	// a cell outside the grid, then the head twice, are not loaded and leave the state as it was
+	std::vector<uint8_t> broken{ buffer.begin(), buffer.begin() + size };
+	const uint16_t outside = GRID_SIZE;
+	std::memcpy(broken.data() + sizeof(sim::SnapshotHeader), &outside, sizeof(outside));
+	mismatches += sim::loadSnapshot(broken, loaded, timer) ? 1 : 0;
+	std::memcpy(broken.data() + sizeof(sim::SnapshotHeader), buffer.data() + sizeof(sim::SnapshotHeader), 4);
+	std::memcpy(broken.data() + sizeof(sim::SnapshotHeader) + 4, broken.data() + sizeof(sim::SnapshotHeader), 4);
+	mismatches += sim::loadSnapshot(broken, loaded, timer) || !isSame(saved, loaded) ? 1 : 0;
+
+	// Every tick of a game is snapshotted, then the game is rewound. Random turns until it dies, so that
+	// the history has turns, apples and the game over step. Snapshots are compared before and after the ring wrapped.
+	for (const size_t capacity : { size_t{ 1 } << 20, size_t{ 256 } }) {
+		sim::State state{ GRID_SIZE, Rng{ 5 } };
+		sim::RewindBuffer rewind{ capacity };
+		std::vector<std::vector<uint8_t>> history;
+		Rng rng{ 6 };
+		bool isOver = false;
+		while (!isOver && state.ticks < 20000) {
+			history.emplace_back(sim::getSnapshotSize(state));
+			sim::saveSnapshot(state, 0, history.back());
+			// along the cycle with a random turn now and then, the snake grows and then dies somewhere
+			sim::Action action = cycleAction(state);
+			if (rng.nextBelow(64) == 0) {
+				// into a free cell, the game should last
+				const bool isLeft = rng.nextBelow(2) == 0;
+				const sim::Action turn = isLeft ? sim::Action::TURN_LEFT : sim::Action::TURN_RIGHT;
+				if (state.snake.getGrid().isEmpty(state.snake.getHead().addCell(Cell::deltaCell(sim::turned(state.snake.getDirection(), turn)))))
+					action = turn;
+			}
+			rewind.capture(state);
+			isOver = sim::isGameOver(sim::step(state, action)) || !state.hasApple;
+			rewind.commit(state);
+		}
+
+		const size_t kept = rewind.getEntryCount();
+		const size_t usedBytes = rewind.getUsedBytes();
+		size_t steps = 0;
+		sim::State expected{ GRID_SIZE, Rng{ 1 } };
+		while (rewind.stepBack(state)) {
+			++steps;
+			sim::loadSnapshot(history[history.size() - steps], expected, timer);
+			if (!isSame(state, expected) && mismatches++ < 10)
+				std::printf("Rewind mismatch at tick %llu\n", static_cast<unsigned long long>(state.ticks));
+		}
+		mismatches += steps == kept ? 0 : 1;
+		std::printf("Rewind %zu bytes: %zu ticks played, %zu kept, %.1f bytes per tick, %d mismatches so far\n", capacity, history.size(), kept,
+			kept > 0 ? static_cast<double>(usedBytes) / kept : 0.0, mismatches);
+	}
+	return mismatches;
+}
+
+// Save and load of a snake that fills 1024 cells, per call. Rewinding per tick.
+void registerSnapshotBenchmarks(bench::Runner& runner) {
+	constexpr int32_t GRID_SIZE = 64;
+	auto state = std::make_shared<sim::State>(playCycle(GRID_SIZE, 1000000));
+	while (state->snake.getCells().size() < 1024)
+		sim::step(*state, cycleAction(*state));
+	auto buffer = std::make_shared<std::vector<uint8_t>>(sim::getMaxSnapshotSize(GRID_SIZE));
+	const std::string length = std::to_string(state->snake.getCells().size());
+
+	runner.add("saveSnapshot/" + length, [state, buffer](uint64_t iterations) {
+		for (uint64_t ix = 0; ix < iterations; ++ix)
+			bench::doNotOptimize(sim::saveSnapshot(*state, 0, *buffer));
+	});
+
+	runner.add("loadSnapshot/" + length, [state, buffer](uint64_t iterations) {
+		const size_t size = sim::saveSnapshot(*state, 0, *buffer);
+		sim::State target = *state;
+		uint32_t timer{};
+		for (uint64_t ix = 0; ix < iterations; ++ix)
+			bench::doNotOptimize(sim::loadSnapshot({ buffer->data(), size }, target, timer));
+	});
+
+	// a tick forward with capture and commit, then back: keeping the history and using it
+	runner.add("RewindBuffer::commit+stepBack/" + length, [state](uint64_t iterations) {
+		sim::RewindBuffer rewind;
+		sim::State game = *state;
+		for (uint64_t ix = 0; ix < iterations; ++ix) {
+			rewind.capture(game);
+			sim::step(game, cycleAction(game));
+			rewind.commit(game);
+			rewind.stepBack(game);
+		}
+		bench::doNotOptimize(game.ticks);
+	});
+}
@@ -0,0 +1,59 @@
+#include "Bench.h"
+
+#include <GameStates.h>
+#include <gds.h>
+
+const int SIZE = 800;
+
+// Headless unless GDS_HEADLESS=0, benchmarks should not depend on a display
+gds::Sdl gds::sdl = gds::Sdl("gds_bench", SIZE, SIZE, gds::SdlSettings::fromEnvironment({ .headless = true }));
+
+void registerSnakeBenchmarks(bench::Runner& runner, StateManager& stateManager);
+void registerRenderBenchmarks(bench::Runner& runner);
+void registerAllocatorBenchmarks(bench::Runner& runner);
+void registerBatchBenchmarks(bench::Runner& runner);
+void registerReplayBenchmarks(bench::Runner& runner);
+void registerSnapshotBenchmarks(bench::Runner& runner);
+void registerPackedBodyBenchmarks(bench::Runner& runner);
+void registerArenaBenchmarks(bench::Runner& runner);
+void registerAutopilotBenchmarks(bench::Runner& runner);
+int verifyBatchSim();
+int verifyReplay();
+int verifySnapshots();
+int verifyPackedBody();
+int verifyArena();
+int verifyAutopilot();
+
+// Usage: gds_bench [--filter s] [--repetitions n] [--min-time-ms t] [--json out.json] [--baseline previous.json] [--verify]
+// Exits with 1 if a benchmark regressed against the baseline.
+// --verify runs the checks instead and exits with 1 on a mismatch: the batch simulator broke the rules, a replay,
+// snapshot or rewind did not give back the state it came from, a packed body decoded to other cells, the arena
+// resolved a tick differently from scanning every body, or the autopilot died or lost track of the apple.
+int main(int argc, char* args[]) {
+	const bench::Settings settings = bench::Settings::fromArgs(argc, args);
+	bench::Runner runner{ settings };
+	if (settings.isVerifying) {
+		runner.addCheck("BatchSim", verifyBatchSim);
+		runner.addCheck("Replay", verifyReplay);
+		runner.addCheck("Snapshot", verifySnapshots);
+		runner.addCheck("PackedBody", verifyPackedBody);
+		runner.addCheck("Arena", verifyArena);
+		runner.addCheck("Autopilot", verifyAutopilot);
+		return runner.runChecks() == 0 ? 0 : 1;
+	}
+
+	gds::sdl.loadFont(gds::DEFAULT_FONT, "assets/fonts/enter_command/EnterCommand.ttf", 28);
+	gds::sdl.loadFont(gds::TITLE_FONT, "assets/fonts/enter_command/EnterCommand.ttf", 40);
+	StateManager stateManager;
+
+	registerSnakeBenchmarks(runner, stateManager);
+	registerRenderBenchmarks(runner);
+	registerAllocatorBenchmarks(runner);
+	registerBatchBenchmarks(runner);
+	registerReplayBenchmarks(runner);
+	registerSnapshotBenchmarks(runner);
+	registerPackedBodyBenchmarks(runner);
+	registerArenaBenchmarks(runner);
+	registerAutopilotBenchmarks(runner);
+	return runner.runAll() == 0 ? 0 : 1;
+}
@@ -0,0 +1,119 @@
+#include "AllocationTracker.h"
+
+#include <SDL.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace gds {
+
+constinit AllocationTracker allocationTracker;
+
+namespace {
+
+// name of the innermost armed NoAllocationScope of this thread
+thread_local const char* forbiddenScope = nullptr;
+
+SDL_malloc_func sdlMalloc = nullptr;
+SDL_calloc_func sdlCalloc = nullptr;
+SDL_realloc_func sdlRealloc = nullptr;
+SDL_free_func sdlFree = nullptr;
+
+void* SDLCALL trackedMalloc(size_t size) {
+	allocationTracker.record(size);
+	return sdlMalloc(size);
+}
+
+void* SDLCALL trackedCalloc(size_t count, size_t size) {
+	allocationTracker.record(count * size);
+	return sdlCalloc(count, size);
+}
+
+void* SDLCALL trackedRealloc(void* ptr, size_t size) {
+	allocationTracker.record(size);
+	return sdlRealloc(ptr, size);
+}
+
+void SDLCALL trackedFree(void* ptr) {
+	sdlFree(ptr);
+}
+
+}
+
+//------------- AllocationTracker
+
+void AllocationTracker::record(size_t size) {
+	count.fetch_add(1, std::memory_order_relaxed);
+	bytes.fetch_add(size, std::memory_order_relaxed);
+	if (forbiddenScope != nullptr) {
+		const char* scope = forbiddenScope;
+		forbiddenScope = nullptr; // reporting must not trip over itself
+		std::fprintf(stderr, "Allocation of %zu bytes in no-allocation scope %s\n", size, scope);
+		std::fflush(stderr);
+		std::abort();
+	}
+}
+
+AllocationStats AllocationTracker::getTotal() const {
+	return { count.load(std::memory_order_relaxed), bytes.load(std::memory_order_relaxed) };
+}
+
+void AllocationTracker::endFrame() {
+	const AllocationStats total = getTotal();
+	lastFrame = { total.count - frameStart.count, total.bytes - frameStart.bytes };
+	frameStart = total;
+}
+
+AllocationStats AllocationTracker::getLastFrameStats() const {
+	return lastFrame;
+}
+
+void AllocationTracker::setAssertMode(bool isEnabled) {
+	isAssertMode = isEnabled;
+}
+
+bool AllocationTracker::getAssertMode() const {
+	return isAssertMode;
+}
+
+void AllocationTracker::installSdlHooks() {
+	if (sdlMalloc != nullptr)
+		return;
+	// has to happen before SDL allocates anything, memory is freed with the functions that allocated it
+	SDL_GetMemoryFunctions(&sdlMalloc, &sdlCalloc, &sdlRealloc, &sdlFree);
+	SDL_SetMemoryFunctions(trackedMalloc, trackedCalloc, trackedRealloc, trackedFree);
+}
+
+//------------- NoAllocationScope
+
+NoAllocationScope::NoAllocationScope(const char* name, bool isArmed)
+	: previous(forbiddenScope), isArmed(isArmed && allocationTracker.getAssertMode()) {
+	if (this->isArmed)
+		forbiddenScope = name;
+}
+
+NoAllocationScope::~NoAllocationScope() {
+	if (isArmed)
+		forbiddenScope = previous;
+}
+
+}
+
+// Replacements of the global allocation functions. The array, nothrow and sized forms
+// forward to these by default. Over-aligned allocations are not counted.
+
+void* operator new(std::size_t size) {
+	gds::allocationTracker.record(size);
+	if (void* ptr = std::malloc(size == 0 ? 1 : size))
+		return ptr;
+	throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept {
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+	std::free(ptr);
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace gds {
+
+struct AllocationStats {
+	uint64_t count{};
+	// requested sizes, frees are not tracked
+	uint64_t bytes{};
+};
+
+// Counts the heap allocations of the process. Global operator new is replaced in AllocationTracker.cpp,
+// SDL's allocator is hooked by installSdlHooks(), which Sdl calls before initializing SDL.
+// Frames are closed by Sdl::renderPresent(), profiler zones record the allocations made inside them.
+//
+// Assert mode: an allocation inside a NoAllocationScope prints the scope and aborts,
+// so that a debugger stops at the allocating call.
+class AllocationTracker {
+private:
+	std::atomic<uint64_t> count{};
+	std::atomic<uint64_t> bytes{};
+	AllocationStats frameStart{};
+	AllocationStats lastFrame{};
+	bool isAssertMode = false;
+public:
+	constexpr AllocationTracker() = default;
+
+	void record(size_t size);
+	AllocationStats getTotal() const;
+
+	void endFrame();
+	AllocationStats getLastFrameStats() const;
+
+	void setAssertMode(bool isEnabled);
+	bool getAssertMode() const;
+
+	static void installSdlHooks();
+};
+
+// constant initialized, allocations made during static initialization are counted too
+extern constinit AllocationTracker allocationTracker;
+
+// In assert mode, allocating on this thread while the scope is armed aborts. Scopes nest.
+class NoAllocationScope {
+private:
+	const char* previous;
+	bool isArmed;
+public:
+	// name has to be a string literal (or outlive the scope)
+	NoAllocationScope(const char* name, bool isArmed = true);
+	NoAllocationScope(const NoAllocationScope& other) = delete;
+	NoAllocationScope& operator=(const NoAllocationScope& other) = delete;
+	~NoAllocationScope();
+};
+
+}
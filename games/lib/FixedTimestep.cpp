@@ -0,0 +1,96 @@
+#include "FixedTimestep.h"
+
+#include "gds.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace gds {
+
+//------------- FixedTimestep
+
+FixedTimestep::FixedTimestep(const LoopSettings& settings)
+	: settings(settings), frequency(SDL_GetPerformanceFrequency()) {
+	stepCounts = frequency * settings.stepMs / 1000;
+	isVirtualTime = gds::sdl.isHeadless();
+	virtualFrameCounts = settings.targetFps > 0 ? frequency / settings.targetFps : stepCounts;
+	frameCounts = (settings.vsync || settings.targetFps == 0 || isVirtualTime) ? 0 : frequency / settings.targetFps;
+	maxFrameCounts = frequency * settings.maxFrameMs / 1000;
+	previous = SDL_GetPerformanceCounter();
+	frameStart = previous;
+}
+
+double FixedTimestep::toMs(uint64_t counts) const {
+	return 1000.0 * counts / frequency;
+}
+
+void FixedTimestep::beginFrame() {
+	const uint64_t now = SDL_GetPerformanceCounter();
+	const uint64_t frameTime = now - frameStart;
+	frameStart = now;
+
+	const uint64_t simulatedNow = isVirtualTime ? previous + virtualFrameCounts : now;
+	accumulator += std::min(simulatedNow - previous, maxFrameCounts);
+	previous = simulatedNow;
+
+	if (frameCount++ > 0) {
+		const double ms = toMs(frameTime);
+		const double delta = ms - frameTimeMean;
+		frameTimeMean += delta / (frameCount - 1);
+		frameTimeM2 += delta * (ms - frameTimeMean);
+	}
+}
+
+bool FixedTimestep::consumeStep() {
+	if (accumulator < stepCounts)
+		return false;
+	accumulator -= stepCounts;
+	return true;
+}
+
+float FixedTimestep::getAlpha() const {
+	return static_cast<float>(static_cast<double>(accumulator) / stepCounts);
+}
+
+void FixedTimestep::endFrame() {
+	if (frameCounts == 0)
+		return;
+
+	const uint64_t deadline = frameStart + frameCounts;
+	const uint64_t now = SDL_GetPerformanceCounter();
+	// sleep for whole milliseconds but one, SDL_Delay can oversleep by up to a scheduler quantum
+	if (now < deadline) {
+		const uint32_t remainingMs = static_cast<uint32_t>(toMs(deadline - now));
+		if (remainingMs > 1)
+			SDL_Delay(remainingMs - 1);
+	}
+	// then yield for the sub-millisecond rest, a thread that is ready to run gets the core instead of a busy spin
+	while (SDL_GetPerformanceCounter() < deadline)
+		SDL_Delay(0);
+}
+
+void FixedTimestep::skipElapsed() {
+	const uint64_t now = SDL_GetPerformanceCounter();
+	// the blocked time is neither a frame time nor taken off the next frame's sleep
+	frameStart = now;
+	if (!isVirtualTime)
+		previous = now;
+}
+
+const LoopSettings& FixedTimestep::getSettings() const {
+	return settings;
+}
+
+uint64_t FixedTimestep::getFrameCount() const {
+	return frameCount;
+}
+
+double FixedTimestep::getFrameTimeMeanMs() const {
+	return frameTimeMean;
+}
+
+double FixedTimestep::getFrameTimeStdDevMs() const {
+	return frameCount > 2 ? std::sqrt(frameTimeM2 / (frameCount - 2)) : 0.0;
+}
+
+}
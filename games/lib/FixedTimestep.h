@@ -0,0 +1,61 @@
+#pragma once
+
+#include <SDL.h>
+
+#include <cstdint>
+
+namespace gds {
+
+struct LoopSettings {
+	// simulation step. 5 ms divides every snake period, so ticks land exactly on a step.
+	uint32_t stepMs = 5;
+	// frames per second when not using vsync, 0 for unlimited
+	uint32_t targetFps = 60;
+	// present blocks until the vertical blank, no sleeping in the loop then
+	bool vsync = false;
+	// elapsed time is clamped to this, so that a stall (window drag, breakpoint) does not trigger a burst of updates
+	uint32_t maxFrameMs = 250;
+};
+
+// Timing of a fixed timestep game loop based on SDL's high resolution performance counter.
+// Usage per frame: beginFrame(), update while consumeStep(), render with getAlpha(), endFrame().
+class FixedTimestep {
+private:
+	LoopSettings settings;
+	uint64_t frequency{}; // counts per second
+	uint64_t stepCounts{};
+	uint64_t frameCounts{}; // 0 when unlimited
+	uint64_t maxFrameCounts{};
+	// headless: simulated time advances one nominal frame per frame, without sleeping, so that the game runs at full speed
+	bool isVirtualTime = false;
+	uint64_t virtualFrameCounts{};
+	uint64_t previous{}; // simulated time of the last beginFrame()
+	uint64_t accumulator{};
+	uint64_t frameStart{};
+
+	// Welford's running mean and variance of frame times
+	uint64_t frameCount{};
+	double frameTimeMean{};
+	double frameTimeM2{};
+private:
+	double toMs(uint64_t counts) const;
+public:
+	FixedTimestep(const LoopSettings& settings);
+
+	void beginFrame();
+	// true while at least one simulation step is due, each call consumes one step
+	bool consumeStep();
+	// fraction of a step elapsed since the last update, for interpolating renders between steps
+	float getAlpha() const;
+	// yields the CPU until the frame deadline when ahead of schedule
+	void endFrame();
+	// drops the time elapsed since the last beginFrame(), e.g. after the loop blocked while idle
+	void skipElapsed();
+
+	const LoopSettings& getSettings() const;
+	uint64_t getFrameCount() const;
+	double getFrameTimeMeanMs() const;
+	double getFrameTimeStdDevMs() const;
+};
+
+}
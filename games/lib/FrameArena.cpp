@@ -0,0 +1,68 @@
+#include "FrameArena.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace gds {
+
+//------------- FrameArena
+
+FrameArena::FrameArena(size_t capacity, std::pmr::memory_resource* upstream)
+	: buffer(std::make_unique<std::byte[]>(capacity)), capacity(capacity), upstream(upstream) {
+	overflows.reserve(16);
+}
+
+FrameArena::~FrameArena() {
+	// not reset(), it would grow the buffer that is about to be freed
+	for (const Overflow& overflow : overflows)
+		upstream->deallocate(overflow.ptr, overflow.bytes, overflow.alignment);
+}
+
+void* FrameArena::do_allocate(size_t bytes, size_t alignment) {
+	const uintptr_t base = reinterpret_cast<uintptr_t>(buffer.get());
+	const size_t aligned = ((base + offset + alignment - 1) & ~(alignment - 1)) - base;
+	used += bytes;
+	if (aligned + bytes <= capacity) {
+		offset = aligned + bytes;
+		return buffer.get() + aligned;
+	}
+	void* ptr = upstream->allocate(bytes, alignment);
+	overflows.push_back({ ptr, bytes, alignment });
+	return ptr;
+}
+
+void FrameArena::do_deallocate(void*, size_t, size_t) {
+	// freed all at once by reset()
+}
+
+bool FrameArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+	return this == &other;
+}
+
+void FrameArena::reset() {
+	highWater = std::max(highWater, used);
+	for (const Overflow& overflow : overflows)
+		upstream->deallocate(overflow.ptr, overflow.bytes, overflow.alignment);
+	if (!overflows.empty()) {
+		// room for this frame's peak with alignment slack, the next frames like it stay in the buffer
+		overflows.clear();
+		capacity = std::max(capacity * 2, highWater + highWater / 4);
+		buffer = std::make_unique<std::byte[]>(capacity);
+	}
+	offset = 0;
+	used = 0;
+}
+
+size_t FrameArena::getCapacity() const {
+	return capacity;
+}
+
+size_t FrameArena::getUsed() const {
+	return used;
+}
+
+size_t FrameArena::getHighWater() const {
+	return std::max(highWater, used);
+}
+
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+namespace gds {
+
+// Bump allocator for data that lives until the end of the current frame. Deallocation is a no-op,
+// reset() frees everything at once, the owner resets it at the end of every frame.
+//
+// Requests that do not fit go to the upstream resource and are freed on reset. The buffer then grows
+// to the frame's high water mark, so that a steady state frame never reaches the upstream resource.
+// Containers opt in through the std::pmr interface: std::pmr::vector<Cell> cells{ &arena };
+class FrameArena : public std::pmr::memory_resource {
+private:
+	std::unique_ptr<std::byte[]> buffer;
+	size_t capacity{};
+	size_t offset{};
+	// bytes requested this frame, including the ones that went upstream
+	size_t used{};
+	size_t highWater{};
+	std::pmr::memory_resource* upstream;
+	struct Overflow {
+		void* ptr;
+		size_t bytes;
+		size_t alignment;
+	};
+	std::vector<Overflow> overflows;
+protected:
+	void* do_allocate(size_t bytes, size_t alignment) override;
+	void do_deallocate(void* ptr, size_t bytes, size_t alignment) override;
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+public:
+	FrameArena(size_t capacity, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+	FrameArena(const FrameArena& other) = delete;
+	FrameArena& operator=(const FrameArena& other) = delete;
+	~FrameArena();
+
+	// invalidates everything allocated since the last reset
+	void reset();
+
+	size_t getCapacity() const;
+	size_t getUsed() const;
+	// largest frame so far, in bytes
+	size_t getHighWater() const;
+};
+
+}
@@ -0,0 +1,44 @@
+#include "InputQueue.h"
+
+#include <algorithm>
+
+namespace gds {
+
+//------------- InputQueue
+
+InputQueue::InputQueue(size_t capacity) : presses(capacity) {}
+
+void InputQueue::push(const SDL_Event& e) {
+	if (e.type == SDL_KEYDOWN && e.key.repeat == 0)
+		push(KeyPress{ e.key.keysym.sym, e.key.timestamp });
+}
+
+void InputQueue::push(const KeyPress& press) {
+	// the oldest press is the stalest, it goes first
+	if (presses.isFull()) {
+		presses.popFront();
+		++droppedCount;
+	}
+	presses.pushBack(press);
+}
+
+KeyPress InputQueue::pop(uint32_t now) {
+	const KeyPress press = presses.front();
+	presses.popFront();
+	// timestamps wrap after 49 days, unsigned difference still gives the wait
+	const uint32_t latencyMs = now - press.timestamp;
+	++consumedCount;
+	latencySumMs += latencyMs;
+	latencyMaxMs = std::max(latencyMaxMs, latencyMs);
+	return press;
+}
+
+void InputQueue::clear() {
+	presses.clear();
+}
+
+double InputQueue::getMeanLatencyMs() const {
+	return consumedCount > 0 ? static_cast<double>(latencySumMs) / consumedCount : 0.0;
+}
+
+}
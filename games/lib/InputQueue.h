@@ -0,0 +1,54 @@
+#pragma once
+
+#include "RingBuffer.h"
+
+#include <SDL.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace gds {
+
+struct KeyPress {
+	SDL_Keycode key = SDLK_UNKNOWN;
+	// SDL_GetTicks() time of the event in ms
+	uint32_t timestamp{};
+};
+
+// Key presses in the order they came in, for states that take their input in update rather than in handleEvent.
+// Presses between two updates queue up instead of overwriting each other. Bounded: a full queue drops its oldest
+// press, the buffer is allocated once and never grows. Keeps statistics of the time from an event to its consumption.
+class InputQueue {
+private:
+	RingBuffer<KeyPress> presses;
+	uint64_t droppedCount{};
+	uint64_t consumedCount{};
+	uint64_t latencySumMs{};
+	uint32_t latencyMaxMs{};
+
+public:
+	// capacity is rounded up to a power of two
+	InputQueue(size_t capacity = 8);
+
+	// key down events that are not repeats, other events are ignored
+	void push(const SDL_Event& e);
+	void push(const KeyPress& press);
+
+	bool isEmpty() const { return presses.isEmpty(); }
+	size_t size() const { return presses.size(); }
+	// the oldest press, there has to be one
+	const KeyPress& front() const { return presses.front(); }
+
+	// removes the oldest press, now - its timestamp goes into the latency statistics
+	KeyPress pop(uint32_t now);
+	// forgets the pending presses, e.g. when the state is left
+	void clear();
+
+	// presses pushed out of a full queue
+	uint64_t getDroppedCount() const { return droppedCount; }
+	uint64_t getConsumedCount() const { return consumedCount; }
+	double getMeanLatencyMs() const;
+	uint32_t getMaxLatencyMs() const { return latencyMaxMs; }
+};
+
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace gds {
+
+// Fixed size blocks carved out of chunks, recycled through an intrusive free list. O(1) allocate and free,
+// memory goes back to the upstream resource only when the pool is destroyed.
+// As a std::pmr resource it serves requests up to the block size and alignment, larger ones go upstream.
+// Useful for node based containers whose node size is known: std::pmr::list<Cell> cells{ &pool };
+class BlockPool : public std::pmr::memory_resource {
+private:
+	struct FreeBlock {
+		FreeBlock* next;
+	};
+	size_t blockAlignment;
+	// blocks hold a free list link while free, and have to stay aligned next to each other
+	size_t blockSize;
+	size_t blocksPerChunk;
+	std::pmr::memory_resource* upstream;
+	std::vector<std::byte*> chunks;
+	FreeBlock* freeList = nullptr;
+	size_t liveBlocks{};
+private:
+	void addChunk() {
+		std::byte* chunk = static_cast<std::byte*>(upstream->allocate(blockSize * blocksPerChunk, blockAlignment));
+		chunks.push_back(chunk);
+		// thread the new blocks onto the free list, first block on top
+		for (size_t ix = blocksPerChunk; ix-- > 0;)
+			freeList = new (chunk + ix * blockSize) FreeBlock{ freeList };
+	}
+protected:
+	void* do_allocate(size_t bytes, size_t alignment) override {
+		if (bytes > blockSize || alignment > blockAlignment)
+			return upstream->allocate(bytes, alignment);
+		return allocateBlock();
+	}
+
+	void do_deallocate(void* ptr, size_t bytes, size_t alignment) override {
+		if (bytes > blockSize || alignment > blockAlignment)
+			upstream->deallocate(ptr, bytes, alignment);
+		else
+			freeBlock(ptr);
+	}
+
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+		return this == &other;
+	}
+public:
+	BlockPool(size_t blockSize, size_t blockAlignment, size_t blocksPerChunk = 256, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+		: blockAlignment(std::max(blockAlignment, alignof(FreeBlock))),
+		blockSize((std::max(blockSize, sizeof(FreeBlock)) + this->blockAlignment - 1) / this->blockAlignment * this->blockAlignment),
+		blocksPerChunk(blocksPerChunk), upstream(upstream) {}
+	BlockPool(const BlockPool& other) = delete;
+	BlockPool& operator=(const BlockPool& other) = delete;
+
+	~BlockPool() {
+		assert(liveBlocks == 0); // blocks outliving their pool
+		for (std::byte* chunk : chunks)
+			upstream->deallocate(chunk, blockSize * blocksPerChunk, blockAlignment);
+	}
+
+	void* allocateBlock() {
+		if (freeList == nullptr)
+			addChunk();
+		FreeBlock* block = freeList;
+		freeList = block->next;
+		++liveBlocks;
+		return block;
+	}
+
+	void freeBlock(void* ptr) {
+		assert(liveBlocks > 0);
+		--liveBlocks;
+		freeList = new (ptr) FreeBlock{ freeList };
+	}
+
+	// preallocates chunks so that the first `count` blocks do not reach the upstream resource
+	void reserve(size_t count) {
+		while (chunks.size() * blocksPerChunk < count)
+			addChunk();
+	}
+
+	size_t getBlockSize() const { return blockSize; }
+	size_t getLiveBlockCount() const { return liveBlocks; }
+};
+
+// Typed pool of T on top of a BlockPool. Objects are constructed in place and destroyed back into the pool.
+template<typename T>
+class ObjectPool {
+private:
+	BlockPool blocks;
+public:
+	ObjectPool(size_t objectsPerChunk = 256, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+		: blocks(sizeof(T), alignof(T), objectsPerChunk, upstream) {}
+
+	template<typename... Args>
+	T* create(Args&&... args) {
+		void* ptr = blocks.allocateBlock();
+		return new (ptr) T(std::forward<Args>(args)...);
+	}
+
+	void destroy(T* obj) {
+		if (obj == nullptr)
+			return;
+		obj->~T();
+		blocks.freeBlock(obj);
+	}
+
+	void reserve(size_t count) { blocks.reserve(count); }
+	size_t getLiveCount() const { return blocks.getLiveBlockCount(); }
+	// the underlying std::pmr resource, serves allocations up to sizeof(T)
+	BlockPool& getResource() { return blocks; }
+};
+
+}
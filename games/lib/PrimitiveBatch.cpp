@@ -0,0 +1,53 @@
+#include "PrimitiveBatch.h"
+
+#include <gds.h>
+#include <Profiler.h>
+
+namespace gds {
+
+//------------- PrimitiveBatch
+
+void PrimitiveBatch::reserve(size_t quadCount) {
+	vertices.reserve(quadCount * 4);
+	indices.reserve(quadCount * 6);
+}
+
+void PrimitiveBatch::addQuad(const SDL_FRect& dst, const SDL_FRect& uv, SDL_Color color) {
+	const int base = static_cast<int>(vertices.size());
+	vertices.push_back({ { dst.x, dst.y }, color, { uv.x, uv.y } });
+	vertices.push_back({ { dst.x + dst.w, dst.y }, color, { uv.x + uv.w, uv.y } });
+	vertices.push_back({ { dst.x + dst.w, dst.y + dst.h }, color, { uv.x + uv.w, uv.y + uv.h } });
+	vertices.push_back({ { dst.x, dst.y + dst.h }, color, { uv.x, uv.y + uv.h } });
+	indices.insert(indices.end(), { base, base + 1, base + 2, base + 2, base + 3, base });
+}
+
+void PrimitiveBatch::addRect(const SDL_FRect& rect, SDL_Color color) {
+	if (texture != nullptr)
+		flush();
+	addQuad(rect, {}, color);
+}
+
+void PrimitiveBatch::addTexturedQuad(SDL_Texture* tex, const SDL_FRect& dst, const SDL_FRect& uv, SDL_Color color) {
+	if (tex != texture)
+		flush();
+	texture = tex;
+	addQuad(dst, uv, color);
+}
+
+void PrimitiveBatch::flush() {
+	GDS_PROFILE_ZONE("PrimitiveBatch::flush");
+	if (!isEmpty()) {
+		SDL_RenderGeometry(gds::sdl.renderer, texture, vertices.data(), static_cast<int>(vertices.size()), indices.data(), static_cast<int>(indices.size()));
+		gds::sdl.countDrawCall(static_cast<uint32_t>(vertices.size()));
+	}
+	// clear() keeps the capacity, so a batch stops allocating after the first few frames
+	vertices.clear();
+	indices.clear();
+	texture = nullptr;
+}
+
+bool PrimitiveBatch::isEmpty() const {
+	return indices.empty();
+}
+
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <SDL.h>
+
+#include <vector>
+
+namespace gds {
+
+// Collects colored rects and textured quads into one vertex buffer.
+// Consecutive quads that use the same texture (or none) are submitted with a single SDL_RenderGeometry call.
+// Untextured quads are drawn with the blend mode of the renderer, textured ones with the blend mode of their texture.
+class PrimitiveBatch {
+private:
+	std::vector<SDL_Vertex> vertices;
+	std::vector<int> indices;
+	// texture of the pending run, nullptr for colored rects
+	SDL_Texture* texture = nullptr;
+private:
+	void addQuad(const SDL_FRect& dst, const SDL_FRect& uv, SDL_Color color);
+public:
+	void addRect(const SDL_FRect& rect, SDL_Color color);
+	// uv is in normalized texture coordinates
+	void addTexturedQuad(SDL_Texture* tex, const SDL_FRect& dst, const SDL_FRect& uv, SDL_Color color = { 0xFF, 0xFF, 0xFF, 0xFF });
+
+	// makes room for quadCount quads, so that batches up to that size do not allocate
+	void reserve(size_t quadCount);
+
+	// Submits pending quads, has to be called before any other draw call that should appear on top of them
+	void flush();
+	bool isEmpty() const;
+};
+
+}
@@ -0,0 +1,128 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+namespace gds {
+
+Profiler profiler;
+
+//------------- Profiler
+
+Profiler::Profiler()
+	: frequency(SDL_GetPerformanceFrequency()), frames(MAX_FRAMES), zones(static_cast<size_t>(MAX_FRAMES) * MAX_ZONES_PER_FRAME) {
+	currentFrame().start = SDL_GetPerformanceCounter();
+	currentFrame().allocations = allocationTracker.getTotal();
+}
+
+Profiler::Frame& Profiler::currentFrame() {
+	return frames[frameIx % MAX_FRAMES];
+}
+
+const Profiler::Zone* Profiler::getZones(uint64_t ix) const {
+	return &zones[(ix % MAX_FRAMES) * MAX_ZONES_PER_FRAME];
+}
+
+uint32_t Profiler::beginZone(const char* name) {
+	Frame& frame = currentFrame();
+	if (frame.zoneCount == MAX_ZONES_PER_FRAME) {
+		++droppedZones;
+		return UINT32_MAX;
+	}
+	const uint32_t handle = frame.zoneCount++;
+	zones[(frameIx % MAX_FRAMES) * MAX_ZONES_PER_FRAME + handle] = Zone{ name, SDL_GetPerformanceCounter(), 0, depth++, allocationTracker.getTotal() };
+	return handle;
+}
+
+void Profiler::endZone(uint32_t handle) {
+	if (handle == UINT32_MAX)
+		return;
+	--depth;
+	Zone& zone = zones[(frameIx % MAX_FRAMES) * MAX_ZONES_PER_FRAME + handle];
+	zone.end = SDL_GetPerformanceCounter();
+	// totals at the start of the zone become the allocations made inside it
+	const AllocationStats total = allocationTracker.getTotal();
+	zone.allocations = { total.count - zone.allocations.count, total.bytes - zone.allocations.bytes };
+}
+
+void Profiler::endFrame() {
+	const uint64_t now = SDL_GetPerformanceCounter();
+	const AllocationStats total = allocationTracker.getTotal();
+	Frame& frame = currentFrame();
+	frame.end = now;
+	frame.allocations = { total.count - frame.allocations.count, total.bytes - frame.allocations.bytes };
+	++frameIx;
+	currentFrame() = Frame{ now, 0, 0, total };
+}
+
+uint64_t Profiler::getFirstFrameIx() const {
+	return frameIx > MAX_FRAMES - 1 ? frameIx - (MAX_FRAMES - 1) : 0;
+}
+
+uint64_t Profiler::getFrameIx() const {
+	return frameIx;
+}
+
+double Profiler::getFrameMs(uint64_t ix) const {
+	const Frame& frame = frames[ix % MAX_FRAMES];
+	return 1000.0 * (frame.end - frame.start) / frequency;
+}
+
+AllocationStats Profiler::getFrameAllocations(uint64_t ix) const {
+	return frames[ix % MAX_FRAMES].allocations;
+}
+
+uint64_t Profiler::getDroppedZoneCount() const {
+	return droppedZones;
+}
+
+bool Profiler::exportChromeTrace(const std::string& path) const {
+	std::ofstream out{ path };
+	if (!out) {
+		std::cerr << "Could not open " << path << " to write the trace\n";
+		return false;
+	}
+
+	const uint64_t origin = frames[getFirstFrameIx() % MAX_FRAMES].start;
+	auto toUs = [&](uint64_t counter) { return 1e6 * static_cast<double>(counter - origin) / frequency; };
+	bool isFirst = true;
+	auto writeEvent = [&](const char* name, uint64_t start, uint64_t end, const AllocationStats& allocations) {
+		out << (isFirst ? "\n" : ",\n")
+			<< R"({"name":")" << name << R"(","ph":"X","pid":0,"tid":0,"ts":)" << toUs(start) << R"(,"dur":)" << toUs(end) - toUs(start)
+			<< R"(,"args":{"allocations":)" << allocations.count << R"(,"allocated_bytes":)" << allocations.bytes << "}}";
+		isFirst = false;
+	};
+
+	out << R"({"displayTimeUnit":"ms","traceEvents":[)";
+	for (uint64_t ix = getFirstFrameIx(); ix < frameIx; ++ix) {
+		const Frame& frame = frames[ix % MAX_FRAMES];
+		writeEvent("Frame", frame.start, frame.end, frame.allocations);
+		const Zone* frameZones = getZones(ix);
+		for (uint32_t zx = 0; zx < frame.zoneCount; ++zx)
+			if (frameZones[zx].end >= frameZones[zx].start) // skip zones left open at the end of the frame
+				writeEvent(frameZones[zx].name, frameZones[zx].start, frameZones[zx].end, frameZones[zx].allocations);
+	}
+	out << "\n]}\n";
+	return static_cast<bool>(out);
+}
+
+void Profiler::renderFrameGraph(const SDL_Rect& area, float budgetMs) {
+	graphBatch.addRect({ static_cast<float>(area.x), static_cast<float>(area.y), static_cast<float>(area.w), static_cast<float>(area.h) }, { 0x00, 0x00, 0x00, 0xFF });
+
+	// budget line at half height, so frames up to twice the budget fit
+	const float msToPixels = area.h / (2.0f * budgetMs);
+	const float barWidth = static_cast<float>(area.w) / (MAX_FRAMES - 1);
+	const float bottom = static_cast<float>(area.y + area.h);
+	const uint64_t first = getFirstFrameIx();
+	for (uint64_t ix = first; ix < frameIx; ++ix) {
+		const float ms = static_cast<float>(getFrameMs(ix));
+		const float barHeight = std::min(ms * msToPixels, static_cast<float>(area.h));
+		const SDL_Color color = ms <= budgetMs ? SDL_Color{ 0x22, 0xCC, 0x33, 0xFF } : SDL_Color{ 0xCC, 0x22, 0x33, 0xFF };
+		graphBatch.addRect({ area.x + (ix - first) * barWidth, bottom - barHeight, barWidth, barHeight }, color);
+	}
+	graphBatch.addRect({ static_cast<float>(area.x), bottom - budgetMs * msToPixels, static_cast<float>(area.w), 1.0f }, { 0xCC, 0xCC, 0xCC, 0xFF });
+	graphBatch.flush();
+}
+
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "AllocationTracker.h"
+#include "PrimitiveBatch.h"
+
+#include <SDL.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Zones are compiled in only when GDS_PROFILING is defined (CMake option GDS_ENABLE_PROFILER),
+// otherwise the macros expand to nothing.
+#ifdef GDS_PROFILING
+#define GDS_PROFILE_CONCAT_IMPL(a, b) a##b
+#define GDS_PROFILE_CONCAT(a, b) GDS_PROFILE_CONCAT_IMPL(a, b)
+// times the rest of the enclosing scope, name has to be a string literal (or outlive the profiler)
+#define GDS_PROFILE_ZONE(name) gds::ProfileZone GDS_PROFILE_CONCAT(gdsProfileZone, __LINE__){ name }
+// closes the current frame, call once per loop iteration
+#define GDS_PROFILE_FRAME() gds::profiler.endFrame()
+#else
+#define GDS_PROFILE_ZONE(name) ((void)0)
+#define GDS_PROFILE_FRAME() ((void)0)
+#endif
+
+namespace gds {
+
+// Records nested zone timings of the last MAX_FRAMES frames into preallocated storage.
+// Recording does not allocate. Zones beyond MAX_ZONES_PER_FRAME in a frame are dropped and counted.
+class Profiler {
+public:
+	static constexpr uint32_t MAX_FRAMES = 256;
+	static constexpr uint32_t MAX_ZONES_PER_FRAME = 512;
+
+	struct Zone {
+		const char* name = nullptr;
+		uint64_t start{};
+		uint64_t end{};
+		uint32_t depth{};
+		// made inside the zone, nested zones included
+		AllocationStats allocations{};
+	};
+
+	struct Frame {
+		uint64_t start{};
+		uint64_t end{};
+		uint32_t zoneCount{};
+		AllocationStats allocations{};
+	};
+
+private:
+	uint64_t frequency{};
+	// frames[frameIx % MAX_FRAMES], zones of a frame at zones[slot * MAX_ZONES_PER_FRAME]
+	std::vector<Frame> frames;
+	std::vector<Zone> zones;
+	uint64_t frameIx = 0; // current, still open frame
+	uint32_t depth = 0;
+	uint64_t droppedZones = 0;
+	PrimitiveBatch graphBatch;
+private:
+	Frame& currentFrame();
+	const Zone* getZones(uint64_t ix) const;
+public:
+	Profiler();
+
+	// returns a handle for endZone(), UINT32_MAX if the zone was dropped
+	uint32_t beginZone(const char* name);
+	void endZone(uint32_t handle);
+	void endFrame();
+
+	// closed frames that are still in the ring, oldest first
+	uint64_t getFirstFrameIx() const;
+	uint64_t getFrameIx() const;
+	double getFrameMs(uint64_t ix) const;
+	AllocationStats getFrameAllocations(uint64_t ix) const;
+	uint64_t getDroppedZoneCount() const;
+
+	// writes complete ("X") events of the recorded frames, open with chrome://tracing or ui.perfetto.dev.
+	// Allocation counts and bytes are in the args of each event.
+	bool exportChromeTrace(const std::string& path) const;
+	// bar per recorded frame, green under budgetMs, red above
+	void renderFrameGraph(const SDL_Rect& area, float budgetMs = 1000.0f / 60.0f);
+};
+
+extern Profiler profiler;
+
+class ProfileZone {
+private:
+	uint32_t handle;
+public:
+	ProfileZone(const char* name) : handle(profiler.beginZone(name)) {}
+	ProfileZone(const ProfileZone& other) = delete;
+	ProfileZone& operator=(const ProfileZone& other) = delete;
+	~ProfileZone() { profiler.endZone(handle); }
+};
+
+}
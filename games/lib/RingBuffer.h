@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+namespace gds {
+
+// Growable circular buffer with O(1) push/pop at both ends.
+// Capacity is kept a power of two so that wrapping is a mask instead of a modulus.
+template<typename T>
+class RingBuffer {
+private:
+	std::vector<T> buffer;
+	size_t first = 0; // buffer index of the front element
+	size_t count = 0;
+private:
+	size_t wrap(size_t ix) const { return ix & (buffer.size() - 1); }
+
+	void grow() {
+		std::vector<T> larger(buffer.size() * 2);
+		for (size_t ix = 0; ix < count; ++ix)
+			larger[ix] = std::move(buffer[wrap(first + ix)]);
+		buffer = std::move(larger);
+		first = 0;
+	}
+public:
+	class Iterator {
+	private:
+		const RingBuffer* ring = nullptr;
+		size_t ix = 0; // from front
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = T;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const T*;
+		using reference = const T&;
+
+		Iterator() = default;
+		Iterator(const RingBuffer* ring, size_t ix) : ring(ring), ix(ix) {}
+
+		reference operator*() const { return (*ring)[ix]; }
+		pointer operator->() const { return &(*ring)[ix]; }
+		Iterator& operator++() { ++ix; return *this; }
+		Iterator operator++(int) { Iterator tmp = *this; ++ix; return tmp; }
+		bool operator==(const Iterator& other) const { return ix == other.ix; }
+	};
+
+	RingBuffer(size_t minCapacity = 16) {
+		size_t capacity = 1;
+		while (capacity < minCapacity)
+			capacity *= 2;
+		buffer.resize(capacity);
+	}
+
+	size_t size() const { return count; }
+	size_t capacity() const { return buffer.size(); }
+	bool isEmpty() const { return count == 0; }
+	bool isFull() const { return count == buffer.size(); }
+	void clear() { first = 0; count = 0; }
+
+	// ix is counted from the front
+	const T& operator[](size_t ix) const { assert(ix < count); return buffer[wrap(first + ix)]; }
+	T& operator[](size_t ix) { assert(ix < count); return buffer[wrap(first + ix)]; }
+	const T& front() const { return (*this)[0]; }
+	T& front() { return (*this)[0]; }
+	const T& back() const { return (*this)[count - 1]; }
+	T& back() { return (*this)[count - 1]; }
+
+	void pushFront(const T& val) {
+		if (isFull())
+			grow();
+		first = wrap(first + buffer.size() - 1);
+		buffer[first] = val;
+		++count;
+	}
+
+	void pushBack(const T& val) {
+		if (isFull())
+			grow();
+		buffer[wrap(first + count)] = val;
+		++count;
+	}
+
+	void popFront() {
+		assert(!isEmpty());
+		first = wrap(first + 1);
+		--count;
+	}
+
+	void popBack() {
+		assert(!isEmpty());
+		--count;
+	}
+
+	Iterator begin() const { return Iterator{ this, 0 }; }
+	Iterator end() const { return Iterator{ this, count }; }
+};
+
+}
@@ -1,6 +1,7 @@
 #include "Widgets.h"
 
 #include <gds.h>
+#include <Profiler.h>
 
 #include <cassert>
 
@@ -30,7 +31,7 @@ void Button::registerCallback(std::function<void()> func) {
 
 //------------- Selector
 
-Selector::Selector(const std::string& label, const std::vector<std::string> options, int32_t initialIx)
+Selector::Selector(const std::string& label, const std::vector<std::string>& options, int32_t initialIx)
 	: label(label), options(options), selectionIx(initialIx) {
 	for (const auto& opt : options) {
 		textTexes.emplace_back(label + ": " + opt, gds::sdl.getFont(gds::DEFAULT_FONT), SDL_Color{ 0xCC, 0x22, 0x33 });
@@ -69,7 +70,7 @@ Button& MenuPage::addButton(const std::string& text) {
 	return w;
 }
 
-Selector& MenuPage::addSelector(const std::string& label, const std::vector<std::string> options, int32_t initialIx) {
+Selector& MenuPage::addSelector(const std::string& label, const std::vector<std::string>& options, int32_t initialIx) {
 	widgets.push_back(std::make_unique<Selector>(label, options, initialIx));
 
 	Selector& w = static_cast<Selector&>(*widgets.back());
@@ -88,6 +89,7 @@ gds::TextTexture& MenuPage::addTextTexture(const std::string& text, gds::Font& f
 }
 
 void MenuPage::render() {
+	GDS_PROFILE_ZONE("MenuPage::render");
 	for (int ix = 0; ix < textures.size(); ++ix) {
 		textures[ix].render(texturePositions[ix]);
 	}
@@ -98,6 +100,7 @@ void MenuPage::render() {
 
 	SDL_SetRenderDrawColor(gds::sdl.renderer, 0xCC, 0x22, 0x33, 0xFF);
 	SDL_RenderFillRect(gds::sdl.renderer, &selectionIndicator);
+	gds::sdl.countDrawCall();
 }
 
 void MenuPage::handleKeys(SDL_Keycode key) {
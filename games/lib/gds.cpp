@@ -1,6 +1,12 @@
 #include "gds.h"
 
+#include "AllocationTracker.h"
+#include "Profiler.h"
+
+#include <algorithm>
 #include <cassert>
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
 
 namespace gds {
@@ -18,14 +24,46 @@ bool Result::assertOK() const {
 	return isOK;
 }
 
+//------------- SdlSettings
+
+SdlSettings SdlSettings::fromEnvironment(SdlSettings defaults) {
+	SdlSettings settings = defaults;
+	if (const char* val = std::getenv("GDS_HEADLESS"))
+		settings.headless = std::string_view{ val } != "0";
+	if (const char* val = std::getenv("GDS_HEADLESS_SIZE"))
+		if (std::sscanf(val, "%dx%d", &settings.headlessWidth, &settings.headlessHeight) != 2)
+			std::cerr << "GDS_HEADLESS_SIZE should be like 640x480, got " << val << "\n";
+	if (const char* val = std::getenv("GDS_DUMP_FRAMES"))
+		settings.frameDumpDir = val;
+	if (const char* val = std::getenv("GDS_DUMP_INTERVAL"))
+		settings.frameDumpInterval = std::max(1, std::atoi(val));
+	if (const char* val = std::getenv("GDS_MAX_FRAMES"))
+		settings.maxFrames = std::strtoull(val, nullptr, 10);
+	return settings;
+}
+
+
 //------------- Sdl
 
-Sdl::Sdl(const std::string& name, int width, int height) : name(name), width(width), height(height) {
+Sdl::Sdl(const std::string& name, int width, int height, const SdlSettings& settings) : name(name), width(width), height(height), settings(settings) {
+	AllocationTracker::installSdlHooks();
+	if (settings.headless)
+		SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
 	SDL_Init(SDL_INIT_VIDEO);
 	TTF_Init();
-	window = SDL_CreateWindow(name.c_str(), SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, width, height, SDL_WINDOW_SHOWN);
-	//SDL_Surface* gScreenSurface = SDL_GetWindowSurface(gWindow);
-	renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+	if (settings.headless) {
+		const int w = settings.headlessWidth > 0 ? settings.headlessWidth : width;
+		const int h = settings.headlessHeight > 0 ? settings.headlessHeight : height;
+		offscreen = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, SDL_PIXELFORMAT_ARGB8888);
+		renderer = SDL_CreateSoftwareRenderer(offscreen);
+		// games keep drawing in their own coordinates, scaled to the offscreen resolution
+		SDL_RenderSetLogicalSize(renderer, width, height);
+	}
+	else {
+		window = SDL_CreateWindow(name.c_str(), SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, width, height, SDL_WINDOW_SHOWN);
+		//SDL_Surface* gScreenSurface = SDL_GetWindowSurface(gWindow);
+		renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+	}
 
 	// Should be able to render into textures
 	SDL_RendererInfo info{};
@@ -40,10 +78,21 @@ Sdl::~Sdl() {
 	TTF_Quit();
 
 	SDL_DestroyRenderer(renderer);
-	SDL_DestroyWindow(window);
+	if (window != nullptr)
+		SDL_DestroyWindow(window);
+	if (offscreen != nullptr)
+		SDL_FreeSurface(offscreen);
 	SDL_Quit();
 }
 
+bool Sdl::isHeadless() const {
+	return settings.headless;
+}
+
+uint64_t Sdl::getPresentedFrameCount() const {
+	return presentedFrames;
+}
+
 Font& Sdl::loadFont(const std::string& name, const char* file, int size, int style) {
 	assert(!fonts.contains(name)); // can't emplace a font with the same name
 	//auto [it, hasEmplaced] = fonts.emplace(name, Font{ file, size, style });
@@ -57,8 +106,45 @@ Font& Sdl::getFont(const std::string& name) {
 	return fonts.at(name);
 }
 
-void Sdl::renderPresent() const {
+void Sdl::setVsync(bool isOn) {
+	Result(SDL_RenderSetVSync(renderer, isOn ? 1 : 0)).assertOK();
+}
+
+void Sdl::renderPresent() {
+	GDS_PROFILE_ZONE("Sdl::renderPresent");
 	SDL_RenderPresent(renderer);
+	lastFrameStats = frameStats;
+	frameStats = {};
+	allocationTracker.endFrame();
+
+	++presentedFrames;
+	if (!settings.frameDumpDir.empty() && presentedFrames % settings.frameDumpInterval == 0)
+		dumpFrame();
+	if (settings.maxFrames > 0 && presentedFrames == settings.maxFrames) {
+		SDL_Event quit{};
+		quit.type = SDL_QUIT;
+		quit.quit = SDL_QuitEvent{ SDL_QUIT, SDL_GetTicks() };
+		SDL_PushEvent(&quit);
+	}
+}
+
+void Sdl::dumpFrame() const {
+	if (offscreen == nullptr) {
+		std::cerr << "Frame dumps are only supported in headless mode\n";
+		return;
+	}
+	char path[512];
+	std::snprintf(path, sizeof(path), "%s/frame_%06llu.bmp", settings.frameDumpDir.c_str(), static_cast<unsigned long long>(presentedFrames));
+	Result(SDL_SaveBMP(offscreen, path)).assertOK();
+}
+
+void Sdl::countDrawCall(uint32_t vertexCount) {
+	++frameStats.drawCalls;
+	frameStats.vertices += vertexCount;
+}
+
+const RenderStats& Sdl::getLastFrameStats() const {
+	return lastFrameStats;
 }
 
 
@@ -72,6 +158,8 @@ Font::Font(const char* file, int size, int style) {
 }
 
 Font::~Font() {
+	// atlas refers to sdlFont
+	atlas.reset();
 	if (sdlFont != nullptr)
 		TTF_CloseFont(sdlFont);
 }
@@ -84,6 +172,138 @@ bool Font::isValid() const {
 	return sdlFont != nullptr;
 }
 
+GlyphAtlas& Font::getAtlas() {
+	assert(isValid());
+	if (!atlas)
+		atlas = std::make_unique<GlyphAtlas>(sdlFont);
+	return *atlas;
+}
+
+
+//------------- GlyphAtlas
+
+GlyphAtlas::GlyphAtlas(TTF_Font* font) : sdlFont(font), lineSkip(TTF_FontLineSkip(font)) {
+	const SDL_Color white{ 0xFF, 0xFF, 0xFF, 0xFF };
+	std::array<SDL_Surface*, LAST_CHAR - FIRST_CHAR + 1> surfaces{};
+
+	// Shelf packing: glyphs are placed left to right, a new row starts when a glyph does not fit
+	SDL_Point cursor{ 0, 0 };
+	int rowHeight = 0;
+	for (char c = FIRST_CHAR; c <= LAST_CHAR; ++c) {
+		Glyph& glyph = glyphs[c - FIRST_CHAR];
+		int minX{}, maxX{}, minY{}, maxY{};
+		TTF_GlyphMetrics(sdlFont, c, &minX, &maxX, &minY, &maxY, &glyph.advance);
+
+		SDL_Surface* surface = TTF_RenderGlyph_Blended(sdlFont, c, white);
+		if (surface == nullptr)
+			continue;
+		surfaces[c - FIRST_CHAR] = surface;
+		if (cursor.x + surface->w > ATLAS_WIDTH) {
+			cursor = { 0, cursor.y + rowHeight + 1 };
+			rowHeight = 0;
+		}
+		glyph.rect = { cursor.x, cursor.y, surface->w, surface->h };
+		// a glyph surface starts left of the pen position when the glyph overhangs to the left
+		glyph.offsetX = std::min(0, minX);
+		cursor.x += surface->w + 1; // 1 pixel padding against bleeding under filtering
+		rowHeight = std::max(rowHeight, surface->h);
+	}
+	textureSize = { ATLAS_WIDTH, cursor.y + rowHeight };
+
+	SDL_Surface* atlasSurface = SDL_CreateRGBSurfaceWithFormat(0, textureSize.x, textureSize.y, 32, SDL_PIXELFORMAT_RGBA32);
+	SDL_FillRect(atlasSurface, NULL, 0);
+	for (size_t ix = 0; ix < surfaces.size(); ++ix) {
+		if (surfaces[ix] == nullptr)
+			continue;
+		// copy alpha as is instead of blending onto the transparent atlas
+		SDL_SetSurfaceBlendMode(surfaces[ix], SDL_BLENDMODE_NONE);
+		SDL_Rect dstRect = glyphs[ix].rect;
+		SDL_BlitSurface(surfaces[ix], NULL, atlasSurface, &dstRect);
+		SDL_FreeSurface(surfaces[ix]);
+	}
+	texture = SDL_CreateTextureFromSurface(gds::sdl.renderer, atlasSurface);
+	SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+	SDL_FreeSurface(atlasSurface);
+}
+
+GlyphAtlas::~GlyphAtlas() {
+	if (texture != nullptr)
+		SDL_DestroyTexture(texture);
+}
+
+char GlyphAtlas::toAtlasChar(char c) {
+	return c < FIRST_CHAR || c > LAST_CHAR ? '?' : c;
+}
+
+const GlyphAtlas::Glyph& GlyphAtlas::getGlyph(char c) const {
+	return glyphs[toAtlasChar(c) - FIRST_CHAR];
+}
+
+template<typename TFunc>
+void GlyphAtlas::layout(std::string_view text, int wrapWidth, TFunc&& func) const {
+	SDL_Point pen{ 0, 0 };
+	char prev = 0;
+	for (size_t ix = 0; ix < text.size(); ++ix) {
+		const char c = text[ix];
+		if (c == '\n') {
+			pen = { 0, pen.y + lineSkip };
+			prev = 0;
+			continue;
+		}
+
+		// move the whole word to the next line if it does not fit
+		const bool isWordStart = c != ' ' && (ix == 0 || text[ix - 1] == ' ');
+		if (wrapWidth > 0 && isWordStart && pen.x > 0) {
+			int wordWidth = 0;
+			for (size_t jx = ix; jx < text.size() && text[jx] != ' ' && text[jx] != '\n'; ++jx)
+				wordWidth += getGlyph(text[jx]).advance;
+			if (pen.x + wordWidth > wrapWidth) {
+				pen = { 0, pen.y + lineSkip };
+				prev = 0;
+			}
+		}
+
+		// kerning between the glyphs that are drawn
+		if (prev != 0)
+			pen.x += TTF_GetFontKerningSizeGlyphs(sdlFont, toAtlasChar(prev), toAtlasChar(c));
+		func(c, pen);
+		pen.x += getGlyph(c).advance;
+		prev = c;
+	}
+}
+
+SDL_Point GlyphAtlas::measure(std::string_view text, int wrapWidth) const {
+	SDL_Point size{ 0, 0 };
+	layout(text, wrapWidth, [&](char c, const SDL_Point& pen) {
+		const Glyph& glyph = getGlyph(c);
+		size.x = std::max(size.x, pen.x + std::max(glyph.advance, glyph.offsetX + glyph.rect.w));
+		size.y = std::max(size.y, pen.y + glyph.rect.h);
+	});
+	return size;
+}
+
+void GlyphAtlas::render(std::string_view text, SDL_Color color, int x, int y, bool center, int wrapWidth) {
+	GDS_PROFILE_ZONE("GlyphAtlas::render");
+	if (center) {
+		const SDL_Point size = measure(text, wrapWidth);
+		x -= size.x / 2;
+		y -= size.y / 2;
+	}
+
+	const float invW = 1.0f / textureSize.x;
+	const float invH = 1.0f / textureSize.y;
+	layout(text, wrapWidth, [&](char c, const SDL_Point& pen) {
+		const Glyph& glyph = getGlyph(c);
+		if (c == ' ' || glyph.rect.w == 0)
+			return;
+		const SDL_FRect dst{ static_cast<float>(x + pen.x + glyph.offsetX), static_cast<float>(y + pen.y), static_cast<float>(glyph.rect.w), static_cast<float>(glyph.rect.h) };
+		const SDL_FRect uv{ glyph.rect.x * invW, glyph.rect.y * invH, glyph.rect.w * invW, glyph.rect.h * invH };
+		// glyphs are white in the atlas, vertex color tints them
+		batch.addTexturedQuad(texture, dst, uv, color);
+	});
+	batch.flush();
+}
+
 
 //------------- Texture
 
@@ -138,8 +358,66 @@ SDL_Point Texture::getSize() const {
 }
 
 void Texture::render(const SDL_Point& pos) {
+	GDS_PROFILE_ZONE("Texture::render");
 	SDL_Rect dstRect{ pos.x, pos.y, width, height };
 	SDL_RenderCopy(gds::sdl.renderer, sdlTexture, NULL, &dstRect);
+	gds::sdl.countDrawCall();
+}
+
+
+//------------- TargetTexture
+
+TargetTexture::TargetTexture(int width, int height)
+	: Texture(SDL_CreateTexture(gds::sdl.renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, width, height)) {
+	// a snapshot is opaque, copy it as is
+	SDL_SetTextureBlendMode(sdlTexture, SDL_BLENDMODE_NONE);
+}
+
+void TargetTexture::beginCapture() {
+	GDS_PROFILE_ZONE("TargetTexture::beginCapture");
+	assert(previousTarget == nullptr || previousTarget != sdlTexture); // no nested captures into the same texture
+	previousTarget = SDL_GetRenderTarget(gds::sdl.renderer);
+	Result(SDL_SetRenderTarget(gds::sdl.renderer, sdlTexture)).assertOK();
+}
+
+void TargetTexture::endCapture() {
+	Result(SDL_SetRenderTarget(gds::sdl.renderer, previousTarget)).assertOK();
+	previousTarget = nullptr;
+}
+
+
+//------------- StreamingTexture
+
+StreamingTexture::StreamingTexture(int width, int height)
+	: Texture(SDL_CreateTexture(gds::sdl.renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STREAMING, width, height)) {
+	if (sdlTexture == nullptr)
+		std::cerr << "Unable to create streaming texture! SDL Error: " << SDL_GetError() << "\n";
+	SDL_SetTextureBlendMode(sdlTexture, SDL_BLENDMODE_NONE);
+	SDL_SetTextureScaleMode(sdlTexture, SDL_ScaleModeNearest);
+}
+
+void StreamingTexture::setPixel(int x, int y, uint32_t color) {
+	const SDL_Rect rect{ x, y, 1, 1 };
+	SDL_UpdateTexture(sdlTexture, &rect, &color, sizeof(color));
+}
+
+uint32_t* StreamingTexture::lock(const SDL_Rect& rect, int& pitch) {
+	void* pixels = nullptr;
+	int pitchBytes = 0;
+	if (SDL_LockTexture(sdlTexture, &rect, &pixels, &pitchBytes) != 0)
+		return nullptr;
+	pitch = pitchBytes / static_cast<int>(sizeof(uint32_t));
+	return static_cast<uint32_t*>(pixels);
+}
+
+void StreamingTexture::unlock() {
+	SDL_UnlockTexture(sdlTexture);
+}
+
+void StreamingTexture::render(const SDL_Rect& src, const SDL_FRect& dst) {
+	GDS_PROFILE_ZONE("StreamingTexture::render");
+	SDL_RenderCopyF(gds::sdl.renderer, sdlTexture, &src, &dst);
+	gds::sdl.countDrawCall();
 }
 
 
@@ -165,19 +443,8 @@ void TextTexture::setText(const std::string & text) {
 
 //-------------
 
-void renderText(const std::string& text, SDL_Color color, int x, int y, TTF_Font* font, bool center) {
-	SDL_Surface* textSurface = TTF_RenderText_Blended_Wrapped(font, text.c_str(), color, 0); // anti-aliased glyphs, TTF_RenderText_Solid() for aliased glyphs
-	if (textSurface == nullptr)
-		std::cerr << "Unable to render text surface! SDL_ttf Error: " << TTF_GetError() << "\n";
-	SDL_Texture* texture = SDL_CreateTextureFromSurface(gds::sdl.renderer, textSurface);
-
-	int texW, texH;
-	SDL_QueryTexture(texture, NULL, NULL, &texW, &texH);
-	SDL_Rect dstrect = center ? SDL_Rect{ x - texW / 2, y - texH / 2, texW, texH } : SDL_Rect{ x, y, texW, texH };
-	SDL_RenderCopy(gds::sdl.renderer, texture, NULL, &dstrect);
-
-	SDL_DestroyTexture(texture);
-	SDL_FreeSurface(textSurface);
+void renderText(std::string_view text, SDL_Color color, int x, int y, Font& font, bool center) {
+	font.getAtlas().render(text, color, x, y, center);
 }
 
 int positiveModulus(int num, int mod) {
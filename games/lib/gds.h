@@ -1,11 +1,16 @@
 #pragma once
 
+#include "PrimitiveBatch.h"
+
 #include <SDL.h>
 #include <SDL_ttf.h>
 
+#include <array>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <vector>
 
 namespace gds {
 
@@ -18,6 +23,31 @@ public:
 };
 
 class Font;
+class GlyphAtlas;
+
+struct RenderStats {
+	uint32_t drawCalls{};
+	uint32_t vertices{};
+};
+
+// Headless mode runs without a display or GPU: dummy video driver, no window,
+// and a software renderer that draws into an offscreen surface.
+struct SdlSettings {
+	bool headless = false;
+	// size of the offscreen surface, 0 for the size given to Sdl. Draw calls are scaled to it.
+	int headlessWidth = 0;
+	int headlessHeight = 0;
+	// directory to write frames into as BMP files, empty for no dumps
+	std::string frameDumpDir{};
+	// dump every n-th presented frame
+	uint32_t frameDumpInterval = 1;
+	// push SDL_QUIT after presenting this many frames, 0 for never
+	uint64_t maxFrames = 0;
+
+	// Overrides defaults from environment variables, so that games run headless without code changes:
+	// GDS_HEADLESS=1, GDS_HEADLESS_SIZE=640x480, GDS_DUMP_FRAMES=dir, GDS_DUMP_INTERVAL=n, GDS_MAX_FRAMES=n
+	static SdlSettings fromEnvironment(SdlSettings defaults);
+};
 
 class Sdl {
 private:
@@ -25,16 +55,33 @@ private:
 	int width{};
 	int height{};
 	std::unordered_map<std::string, Font> fonts;
+	RenderStats frameStats{};
+	RenderStats lastFrameStats{};
+	SdlSettings settings;
+	// render target of the headless software renderer
+	SDL_Surface* offscreen = nullptr;
+	uint64_t presentedFrames{};
+private:
+	void dumpFrame() const;
 public:
-	SDL_Renderer* renderer;
-	SDL_Window* window;
+	SDL_Renderer* renderer = nullptr;
+	SDL_Window* window = nullptr; // nullptr when headless
 public:
-	Sdl(const std::string& name, int width, int height);
+	Sdl(const std::string& name, int width, int height, const SdlSettings& settings = SdlSettings::fromEnvironment(SdlSettings{}));
 	~Sdl();
 
+	bool isHeadless() const;
+	uint64_t getPresentedFrameCount() const;
+
 	Font& loadFont(const std::string& name, const char* file, int size, int style = TTF_STYLE_NORMAL);
 	Font& getFont(const std::string& name);
-	void renderPresent() const;
+	void setVsync(bool isOn);
+	void renderPresent();
+
+	// gds draw paths report their calls here, so that batching gains can be verified
+	void countDrawCall(uint32_t vertexCount = 4);
+	// counts of the last presented frame
+	const RenderStats& getLastFrameStats() const;
 };
 
 // Global Variable to be set in main function
@@ -45,12 +92,53 @@ const std::string TITLE_FONT = "TITLE";
 class Font {
 private:
 	TTF_Font* sdlFont = nullptr;
+	// created lazily at first text render, because it needs a renderer
+	std::unique_ptr<GlyphAtlas> atlas;
 public:
 	Font(const char* file, int size, int style = TTF_STYLE_NORMAL);
 	~Font();
 
 	TTF_Font* const get() const;
 	bool isValid() const;
+	GlyphAtlas& getAtlas();
+};
+
+// Rasterizes printable ASCII glyphs of a font once into a single texture.
+// Text is then drawn as textured quads of a PrimitiveBatch, one draw call per string.
+class GlyphAtlas {
+private:
+	static constexpr char FIRST_CHAR = ' ';
+	static constexpr char LAST_CHAR = '~';
+	static constexpr int ATLAS_WIDTH = 512;
+
+	struct Glyph {
+		SDL_Rect rect{}; // location in the atlas texture
+		int offsetX{}; // from pen position to the left edge of rect
+		int advance{};
+	};
+
+	TTF_Font* sdlFont = nullptr;
+	SDL_Texture* texture = nullptr;
+	SDL_Point textureSize{};
+	int lineSkip{};
+	std::array<Glyph, LAST_CHAR - FIRST_CHAR + 1> glyphs{};
+	PrimitiveBatch batch;
+private:
+	// the character drawn for c, '?' for those outside the atlas. Never negative, bytes >= 0x80 are outside.
+	static char toAtlasChar(char c);
+	const Glyph& getGlyph(char c) const;
+	// calls func(c, pen) for every character with its pen position after kerning and wrapping
+	template<typename TFunc>
+	void layout(std::string_view text, int wrapWidth, TFunc&& func) const;
+public:
+	GlyphAtlas(TTF_Font* font);
+	GlyphAtlas(const GlyphAtlas& other) = delete;
+	GlyphAtlas& operator=(const GlyphAtlas& other) = delete;
+	~GlyphAtlas();
+
+	// wrapWidth = 0 only wraps at new lines, same as TTF_RenderText_Blended_Wrapped
+	SDL_Point measure(std::string_view text, int wrapWidth = 0) const;
+	void render(std::string_view text, SDL_Color color, int x, int y, bool center = false, int wrapWidth = 0);
 };
 
 class Texture {
@@ -79,6 +167,35 @@ public:
 	void render(const SDL_Point& pos);
 };
 
+// A texture that can be drawn into. Used to snapshot a composited frame once and then blit it with a single copy.
+class TargetTexture : public Texture {
+private:
+	SDL_Texture* previousTarget = nullptr;
+public:
+	TargetTexture(int width, int height);
+
+	// redirects draw calls into this texture until endCapture()
+	void beginCapture();
+	// restores the render target that was active at beginCapture()
+	void endCapture();
+};
+
+// A texture written from the CPU, for pixels of which a few change every frame. RGBA8888, opaque and nearest filtered:
+// scaled up, every texel stays a sharp block.
+class StreamingTexture : public Texture {
+public:
+	StreamingTexture(int width, int height);
+
+	// uploads one texel, color as 0xRRGGBBAA
+	void setPixel(int x, int y, uint32_t color);
+	// Write access to the texels of rect, pitch is in texels. Every texel of rect has to be written, the previous
+	// content is not kept. nullptr if the texture can't be locked, otherwise unlock() uploads.
+	uint32_t* lock(const SDL_Rect& rect, int& pitch);
+	void unlock();
+	// copies src texels scaled to dst in a single draw call
+	void render(const SDL_Rect& src, const SDL_FRect& dst);
+};
+
 class TextTexture : public Texture {
 private:
 	std::string text;
@@ -92,8 +209,8 @@ public:
 	void setText(const std::string& text);
 };
 
-// Creates, renders and destroys a new texture every call
-void renderText(const std::string& text, SDL_Color color, int x, int y, TTF_Font* font, bool center = false);
+// Draws from the glyph atlas of the font, no textures are created per call
+void renderText(std::string_view text, SDL_Color color, int x, int y, Font& font, bool center = false);
 
 int positiveModulus(int num, int mod);
 